@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "bench_utils.h"
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+unsigned int bench_rand(unsigned int *state) {
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+load_balancer *bench_load_balancer(bool enable_vnodes) {
+	int fd = open("/dev/null", O_WRONLY);
+	DIE(fd < 0, "open /dev/null failed");
+
+	load_balancer *main = init_load_balancer(enable_vnodes);
+	main->sink = init_response_sink(fd, false);
+	return main;
+}
+
+void bench_free_load_balancer(load_balancer **main) {
+	response_sink *sink = (*main)->sink;
+	int fd = sink->fd;
+	free_load_balancer(main);
+	free_response_sink(&sink);
+	close(fd);
+}
+
+void bench_request(load_balancer *main, char *doc_name, char *doc_content) {
+	request req = {
+		.type = doc_content ? EDIT_DOCUMENT : GET_DOCUMENT,
+		.doc_name = doc_name,
+		.doc_content = doc_content,
+	};
+	sink_write_response(main->sink, loader_forward_request(main, &req));
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <stdio.h>
+
+#include "load_balancer.h"
+
+/**
+ * bench_now() - Returns a monotonic timestamp, in seconds.
+ */
+double bench_now(void);
+
+/**
+ * bench_rand() - Returns the next number of a xorshift generator whose
+ *      state, never 0, is kept by the caller.
+ */
+unsigned int bench_rand(unsigned int *state);
+
+/**
+ * bench_load_balancer() - Creates a load balancer whose responses are
+ *      written to /dev/null, so the benchmarks measure the requests only.
+ */
+load_balancer *bench_load_balancer(bool enable_vnodes);
+
+/**
+ * bench_free_load_balancer() - Frees a load balancer made by
+ *      bench_load_balancer(), together with its sink.
+ */
+void bench_free_load_balancer(load_balancer **main);
+
+/**
+ * bench_request() - Sends an EDIT or a GET through the load balancer and
+ *      writes its responses to the sink.
+ *
+ * @param doc_content: Content of an EDIT, NULL for a GET.
+ */
+void bench_request(load_balancer *main, char *doc_name, char *doc_content);
+
+#endif /* BENCH_UTILS_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark care compara politicile de eliminare ale cache-ului pe trei
+ * traseuri de accesari generate aici, afisand procentul de HIT-uri si
+ * milioanele de operatii pe secunda; fiecare accesare este un GET, urmat de
+ * o adaugare daca cheia nu este in cache, ca in server
+ * - zipf: chei alese cu o distributie Zipf de exponent ZIPF_EXPONENT
+ * - scan: acelasi Zipf pe jumatate din chei, intrerupt periodic de parcurgeri
+ *   secventiale ale celeilalte jumatati, de 4 ori mai lungi decat cache-ul
+ * - loop: chei parcurse ciclic, de 1.25 ori mai multe decat incap in cache
+ *
+ * utilizare: cache_policies [capacitatea cache-ului] [nr. de accesari]
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+
+#define DEFAULT_CAPACITY 1000
+#define DEFAULT_OPS 2000000
+#define NR_KEYS 100000
+#define ZIPF_EXPONENT 0.9
+// accesarile Zipf dintre doua parcurgeri ale traseului scan
+#define SCAN_PERIOD 50000
+
+typedef enum trace_type {
+	TRACE_ZIPF,
+	TRACE_SCAN,
+	TRACE_LOOP,
+	TRACE_TYPES,
+} trace_type;
+
+static const char *trace_names[TRACE_TYPES] = { "zipf", "scan", "loop" };
+
+// functia de repartitie a distributiei Zipf peste primele nr_keys chei
+typedef struct zipf_gen {
+	double *cdf;
+	int nr_keys;
+	unsigned int seed;
+} zipf_gen;
+
+static void zipf_init(zipf_gen *z, int nr_keys) {
+	z->cdf = malloc(nr_keys * sizeof(double));
+	DIE(z->cdf == NULL, "Failed to allocate memory\n");
+	z->nr_keys = nr_keys;
+	z->seed = 1;
+
+	double sum = 0;
+	for (int i = 0; i < nr_keys; i++) {
+		sum += 1 / pow(i + 1, ZIPF_EXPONENT);
+		z->cdf[i] = sum;
+	}
+	for (int i = 0; i < nr_keys; i++)
+		z->cdf[i] /= sum;
+}
+
+/* functie care alege o cheie cu distributia Zipf, cautand binar prima
+ * valoare a functiei de repartitie cel putin egala cu un numar aleator
+*/
+static int zipf_next(zipf_gen *z) {
+	double u = bench_rand(&z->seed) / 4294967296.0;
+	int lo = 0, hi = z->nr_keys - 1;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (z->cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* functie care genereaza un traseu de nr_ops accesari, ca indecsi de chei
+*/
+static int *make_trace(trace_type type, int capacity, int nr_ops) {
+	int *trace = malloc(nr_ops * sizeof(int));
+	DIE(trace == NULL, "Failed to allocate memory\n");
+
+	if (type == TRACE_LOOP) {
+		int loop = capacity + capacity / 4;
+		for (int i = 0; i < nr_ops; i++)
+			trace[i] = i % loop % NR_KEYS;
+		return trace;
+	}
+
+	zipf_gen z;
+	zipf_init(&z, type == TRACE_SCAN ? NR_KEYS / 2 : NR_KEYS);
+	for (int i = 0; i < nr_ops;) {
+		for (int j = 0; j < SCAN_PERIOD && i < nr_ops; j++)
+			trace[i++] = zipf_next(&z);
+		// cheile parcurse nu sunt niciodata alese de Zipf
+		for (int j = 0; type == TRACE_SCAN && j < 4 * capacity && i < nr_ops;
+			 j++)
+			trace[i++] = NR_KEYS / 2 + j % (NR_KEYS / 2);
+	}
+	free(z.cdf);
+	return trace;
+}
+
+int main(int argc, char *argv[]) {
+	int capacity = argc > 1 ? atoi(argv[1]) : DEFAULT_CAPACITY;
+	int nr_ops = argc > 2 ? atoi(argv[2]) : DEFAULT_OPS;
+	DIE(capacity < 1 || nr_ops < 1, "invalid arguments");
+
+	char (*keys)[DOC_NAME_LENGTH] = malloc(NR_KEYS * DOC_NAME_LENGTH);
+	DIE(keys == NULL, "Failed to allocate memory\n");
+	for (int i = 0; i < NR_KEYS; i++)
+		snprintf(keys[i], DOC_NAME_LENGTH, "doc_%d", i);
+
+	printf("%-6s %-8s %8s %8s\n", "trace", "policy", "hit %", "Mops/s");
+	for (int t = 0; t < TRACE_TYPES; t++) {
+		int *trace = make_trace(t, capacity, nr_ops);
+		for (int policy = 0; policy < CACHE_POLICIES; policy++) {
+			cache_config config = { .policy = policy };
+			lru_cache *cache = init_lru_cache(capacity, &config);
+
+			double start = bench_now();
+			for (int i = 0; i < nr_ops; i++) {
+				char *key = keys[trace[i]];
+				if (lru_cache_get(cache, key) == NULL)
+					lru_cache_put(cache, key, key, 0, NULL);
+			}
+			double elapsed = bench_now() - start;
+
+			printf("%-6s %-8s %8.2f %8.2f\n", trace_names[t],
+				   cache_policy_name(policy),
+				   100.0 * cache->hits / (cache->hits + cache->misses),
+				   nr_ops / elapsed / 1e6);
+			free_lru_cache(&cache);
+		}
+		free(trace);
+	}
+
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark pentru indexul bazei de date a unui server: un singur server,
+ * cu un cache de un document, primeste GET-uri pentru documente aleatoare,
+ * deci aproape fiecare GET este un MISS care cauta documentul in baza de
+ * date; timpul per GET trebuie sa ramana constant cand baza de date creste
+ *
+ * utilizare: db_index [nr. maxim de documente] [nr. de GET-uri]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+
+#define DEFAULT_MAX_DOCS 1000000
+#define DEFAULT_GETS 200000
+
+/* functie care masoara durata medie a unui GET cu MISS, in ns, pentru un
+ * server cu nr_docs documente
+*/
+static double miss_latency(int nr_docs, int nr_gets) {
+	load_balancer *main = bench_load_balancer(false);
+	loader_add_server(main, 1, 1);
+
+	char name[DOC_NAME_LENGTH];
+	for (int i = 0; i < nr_docs; i++) {
+		snprintf(name, sizeof(name), "doc_%d", i);
+		bench_request(main, name, "content");
+	}
+	// primul GET executa EDIT-urile din coada, creand documentele
+	bench_request(main, "doc_0", NULL);
+
+	unsigned int seed = 1;
+	double start = bench_now();
+	for (int i = 0; i < nr_gets; i++) {
+		snprintf(name, sizeof(name), "doc_%u", bench_rand(&seed) % nr_docs);
+		bench_request(main, name, NULL);
+	}
+	double elapsed = bench_now() - start;
+
+	bench_free_load_balancer(&main);
+	return elapsed * 1e9 / nr_gets;
+}
+
+int main(int argc, char *argv[]) {
+	int max_docs = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_DOCS;
+	int nr_gets = argc > 2 ? atoi(argv[2]) : DEFAULT_GETS;
+	DIE(max_docs < 1 || nr_gets < 1, "invalid arguments");
+
+	printf("%10s %14s\n", "documents", "ns/GET miss");
+	for (int nr_docs = 1000; nr_docs <= max_docs; nr_docs *= 10)
+		printf("%10d %14.1f\n", nr_docs, miss_latency(nr_docs, nr_gets));
+	return 0;
+}
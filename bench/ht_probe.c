@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark pentru sondarea hashtable-ului cu adresare deschisa: pentru un
+ * numar fix de sloturi, se umple tabela pana la diferiti factori de
+ * incarcare si se masoara durata unui ht_get pentru o cheie existenta (HIT)
+ * si pentru una absenta (MISS), care se opreste la primul grup cu un slot
+ * gol; dupa fiecare masurare, cheile sunt sterse si tabela este refolosita
+ *
+ * utilizare: ht_probe [nr. de cautari]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+#include "list_queue_hashtable_functions.h"
+
+#define DEFAULT_LOOKUPS 2000000
+// tabela mica incape in cache-urile procesorului, cea mare nu
+#define SMALL_SLOTS (1u << 12)
+#define LARGE_SLOTS (1u << 20)
+
+static const double load_factors[] = { 0.25, 0.5, 0.75, 0.875 };
+
+/* functie care masoara durata medie, in ns, a nr_lookups cautari ale unor
+ * chei alese aleator dintre primele nr_keys
+*/
+static double lookup_latency(hashtable_t *ht, char (*keys)[DOC_NAME_LENGTH],
+							 unsigned int nr_keys, int nr_lookups,
+							 long *found) {
+	unsigned int seed = 1;
+	double start = bench_now();
+	for (int i = 0; i < nr_lookups; i++)
+		*found += ht_get(ht, keys[bench_rand(&seed) % nr_keys]) != NULL;
+	return (bench_now() - start) * 1e9 / nr_lookups;
+}
+
+/* functie care afiseaza durata cautarilor pentru o tabela de nr_slots
+ * sloturi, la fiecare factor de incarcare
+*/
+static void probe_table(unsigned int nr_slots, int nr_lookups) {
+	// cheile din a doua jumatate nu sunt niciodata inserate
+	char (*keys)[DOC_NAME_LENGTH] = malloc(2 * nr_slots * DOC_NAME_LENGTH);
+	DIE(keys == NULL, "Failed to allocate memory\n");
+	for (unsigned int i = 0; i < 2 * nr_slots; i++)
+		snprintf(keys[i], DOC_NAME_LENGTH, "doc_%u", i);
+
+	hashtable_t *ht = ht_create_ref(nr_slots / HT_MAX_LOAD_DEN *
+									HT_MAX_LOAD_NUM, hash_string,
+									compare_function);
+	DIE(ht->hmax != nr_slots, "unexpected number of slots");
+
+	for (unsigned int l = 0; l < sizeof(load_factors) / sizeof(double); l++) {
+		unsigned int nr_keys = nr_slots * load_factors[l];
+		for (unsigned int i = 0; i < nr_keys; i++)
+			ht_put(ht, keys[i], 0, keys[i], 0);
+
+		long hits = 0, misses = 0;
+		double hit = lookup_latency(ht, keys, nr_keys, nr_lookups, &hits);
+		double miss = lookup_latency(ht, keys + nr_slots, nr_slots,
+									 nr_lookups, &misses);
+		DIE(hits != nr_lookups || misses != 0, "wrong lookup result");
+		printf("%10u %8.3f %10.1f %10.1f\n", nr_slots, load_factors[l], hit,
+			   miss);
+
+		for (unsigned int i = 0; i < nr_keys; i++)
+			ht_remove_entry(ht, keys[i]);
+	}
+
+	ht_free(ht);
+	free(keys);
+}
+
+int main(int argc, char *argv[]) {
+	int nr_lookups = argc > 1 ? atoi(argv[1]) : DEFAULT_LOOKUPS;
+	DIE(nr_lookups < 1, "invalid arguments");
+
+	printf("%10s %8s %10s %10s\n", "slots", "load", "ns/hit", "ns/miss");
+	probe_table(SMALL_SLOTS, nr_lookups);
+	probe_table(LARGE_SLOTS, nr_lookups);
+	return 0;
+}
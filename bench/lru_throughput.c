@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* microbenchmark pentru calea de HIT a cache-ului LRU: compara cache-ul cu
+ * intrari intruzive, unde un HIT doar reface legaturi, cu un model al
+ * cache-ului vechi, care la fiecare HIT scotea nodul din lista de recente si
+ * il adauga din nou cu dll_add_nth_node (un malloc pentru nod si unul pentru
+ * date), iar la fiecare adaugare copia cheia si valoarea la dimensiunile
+ * maxime; modelul foloseste acelasi hashtable, deci diferenta vine doar din
+ * lista de recente si din alocari
+ *
+ * utilizare: lru_throughput [capacitatea cache-ului] [nr. de operatii]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+#include "list_queue_hashtable_functions.h"
+
+#define DEFAULT_CAPACITY 1000
+#define DEFAULT_OPS 5000000
+
+// cache-ul vechi: cheie -> nodul din lista de recente, ale carui date sunt
+// un info cu copiile cheii si valorii
+typedef struct copying_lru {
+	hashtable_t *ht;
+	dll_t *recent;
+	unsigned int capacity;
+} copying_lru;
+
+static copying_lru *copying_create(unsigned int capacity) {
+	copying_lru *c = malloc(sizeof(copying_lru));
+	DIE(c == NULL, "Failed to allocate memory\n");
+	c->ht = ht_create_ref(capacity, hash_string, compare_function);
+	c->recent = dll_create(sizeof(info));
+	c->capacity = capacity;
+	return c;
+}
+
+/* functie care elimina nodul unei chei din cache-ul vechi
+*/
+static void copying_delete(copying_lru *c, dll_node_t *node) {
+	info *pair = node->data;
+	ht_remove_entry(c->ht, pair->key);
+	dll_remove_node(c->recent, node);
+	free(pair->key);
+	free(pair->value);
+	free(pair);
+	free(node);
+}
+
+static void copying_free(copying_lru *c) {
+	while (c->recent->head)
+		copying_delete(c, c->recent->head);
+	free(c->recent);
+	ht_free(c->ht);
+	free(c);
+}
+
+/* functie care muta un nod la finalul listei de recente, ca in cache-ul
+ * vechi: nodul este eliberat si realocat
+*/
+static void *copying_get(copying_lru *c, char *key) {
+	dll_node_t *node = ht_get(c->ht, key);
+	if (node == NULL)
+		return NULL;
+
+	info pair = *(info *)node->data;
+	dll_remove_node(c->recent, node);
+	free(node->data);
+	free(node);
+	dll_add_nth_node(c->recent, c->recent->size, &pair);
+	ht_put(c->ht, pair.key, 0, c->recent->tail, 0);
+	return pair.value;
+}
+
+/* functie care adauga o cheie absenta, eliminand cea mai veche intrare
+ * daca cache-ul este plin
+*/
+static void copying_put(copying_lru *c, char *key, char *value) {
+	if (c->recent->size == c->capacity)
+		copying_delete(c, c->recent->head);
+
+	info pair;
+	pair.key = calloc(DOC_NAME_LENGTH, sizeof(char));
+	pair.value = calloc(DOC_CONTENT_LENGTH, sizeof(char));
+	DIE(pair.key == NULL || pair.value == NULL,
+		"Failed to allocate memory\n");
+	snprintf(pair.key, DOC_NAME_LENGTH, "%s", key);
+	snprintf(pair.value, DOC_CONTENT_LENGTH, "%s", value);
+	dll_add_nth_node(c->recent, c->recent->size, &pair);
+	ht_put(c->ht, pair.key, 0, c->recent->tail, 0);
+}
+
+/* functie care ruleaza aceeasi secventa de operatii pe unul dintre cele doua
+ * cache-uri: ops GET-uri pe chei aflate in cache, apoi ops GET-uri pe de doua
+ * ori mai multe chei, urmate de o adaugare la fiecare MISS; afiseaza
+ * milioanele de operatii pe secunda ale fiecarei etape
+*/
+static void run(const char *label, lru_cache *cache, copying_lru *copying,
+				char (*keys)[DOC_NAME_LENGTH], unsigned int capacity, int ops) {
+	char *value = "document content";
+	for (unsigned int i = 0; i < capacity; i++) {
+		if (cache)
+			lru_cache_put(cache, keys[i], value, strlen(value) + 1, NULL);
+		else
+			copying_put(copying, keys[i], value);
+	}
+
+	unsigned int seed = 1;
+	long found = 0;
+	double start = bench_now();
+	for (int i = 0; i < ops; i++) {
+		char *key = keys[bench_rand(&seed) % capacity];
+		found += (cache ? lru_cache_get(cache, key) :
+				  copying_get(copying, key)) != NULL;
+	}
+	double hits = bench_now() - start;
+
+	start = bench_now();
+	for (int i = 0; i < ops; i++) {
+		char *key = keys[bench_rand(&seed) % (2 * capacity)];
+		if (cache && lru_cache_get(cache, key) == NULL)
+			lru_cache_put(cache, key, value, strlen(value) + 1, NULL);
+		else if (!cache && copying_get(copying, key) == NULL)
+			copying_put(copying, key, value);
+	}
+	double mixed = bench_now() - start;
+
+	printf("%-12s %14.2f %14.2f\n", label, ops / hits / 1e6,
+		   ops / mixed / 1e6);
+	DIE(found != ops, "a resident key was not found");
+}
+
+int main(int argc, char *argv[]) {
+	int capacity = argc > 1 ? atoi(argv[1]) : DEFAULT_CAPACITY;
+	int ops = argc > 2 ? atoi(argv[2]) : DEFAULT_OPS;
+	DIE(capacity < 1 || ops < 1, "invalid arguments");
+
+	char (*keys)[DOC_NAME_LENGTH] = malloc(2 * capacity * DOC_NAME_LENGTH);
+	DIE(keys == NULL, "Failed to allocate memory\n");
+	for (int i = 0; i < 2 * capacity; i++)
+		snprintf(keys[i], DOC_NAME_LENGTH, "doc_%d", i);
+
+	printf("%-12s %14s %14s\n", "cache", "hit Mops/s", "50% miss Mops/s");
+
+	copying_lru *copying = copying_create(capacity);
+	run("copying", NULL, copying, keys, capacity, ops);
+	copying_free(copying);
+
+	cache_config config = { .policy = CACHE_LRU };
+	lru_cache *cache = init_lru_cache(capacity, &config);
+	run("intrusive", cache, NULL, keys, capacity, ops);
+	free_lru_cache(&cache);
+
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark de contentie pentru coada MPSC: de la 1 la N producatori pun
+ * impreuna acelasi numar de elemente, pe care un singur consumator le scoate
+ * in loturi de WORKER_BATCH, ca un worker; pentru comparatie, acelasi lucru
+ * este facut cu o coada queue_t protejata de un mutex si o variabila de
+ * conditie; consumatorul verifica ordinea elementelor fiecarui producator
+ *
+ * utilizare: mpsc_contention [nr. maxim de producatori] [nr. de elemente]
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+#include "list_queue_hashtable_functions.h"
+
+#define DEFAULT_PRODUCERS 8
+#define DEFAULT_ITEMS 4000000
+#define QUEUE_CAPACITY 4096
+// elementul unui producator: indexul lui in bitii superiori si numarul de
+// ordine in cei inferiori
+#define PRODUCER_SHIFT 40
+
+typedef struct locked_queue {
+	queue_t *q;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+} locked_queue;
+
+typedef struct producer {
+	pthread_t thread;
+	unsigned long id;
+	unsigned long nr_items;
+	// exact una dintre cozi este folosita
+	mpsc_queue_t *mpsc;
+	locked_queue *locked;
+} producer;
+
+static void *producer_thread(void *arg) {
+	producer *p = arg;
+	for (unsigned long i = 0; i < p->nr_items; i++) {
+		unsigned long item = p->id << PRODUCER_SHIFT | i;
+		if (p->mpsc) {
+			mpsc_push(p->mpsc, &item);
+			continue;
+		}
+		pthread_mutex_lock(&p->locked->lock);
+		q_enqueue(p->locked->q, &item);
+		pthread_cond_signal(&p->locked->not_empty);
+		pthread_mutex_unlock(&p->locked->lock);
+	}
+	return NULL;
+}
+
+/* functie care scoate din coada cu mutex pana la max elemente, asteptand
+ * daca nu este niciunul
+*/
+static size_t locked_pop_batch(locked_queue *locked, unsigned long *items,
+							   size_t max) {
+	pthread_mutex_lock(&locked->lock);
+	while (q_is_empty(locked->q))
+		pthread_cond_wait(&locked->not_empty, &locked->lock);
+	size_t n = 0;
+	for (; n < max && !q_is_empty(locked->q); n++) {
+		items[n] = *(unsigned long *)q_front(locked->q);
+		q_dequeue(locked->q);
+	}
+	pthread_mutex_unlock(&locked->lock);
+	return n;
+}
+
+/* functie care ruleaza nr_producers producatori pe una dintre cozi si
+ * returneaza milioanele de elemente pe secunda primite de consumator
+*/
+static double run(int nr_producers, unsigned long nr_items, bool use_mpsc) {
+	mpsc_queue_t *mpsc = NULL;
+	locked_queue locked;
+	if (use_mpsc) {
+		mpsc = mpsc_create(QUEUE_CAPACITY, sizeof(unsigned long));
+	} else {
+		locked.q = q_create(QUEUE_CAPACITY, sizeof(unsigned long));
+		pthread_mutex_init(&locked.lock, NULL);
+		pthread_cond_init(&locked.not_empty, NULL);
+	}
+
+	producer *producers = calloc(nr_producers, sizeof(producer));
+	unsigned long *expected = calloc(nr_producers, sizeof(unsigned long));
+	DIE(producers == NULL || expected == NULL, "Failed to allocate memory\n");
+
+	double start = bench_now();
+	for (int i = 0; i < nr_producers; i++) {
+		producers[i].id = i;
+		producers[i].nr_items = nr_items / nr_producers;
+		producers[i].mpsc = mpsc;
+		producers[i].locked = use_mpsc ? NULL : &locked;
+		DIE(pthread_create(&producers[i].thread, NULL, producer_thread,
+						   &producers[i]) != 0, "pthread_create failed");
+	}
+
+	unsigned long items[WORKER_BATCH];
+	unsigned long total = nr_items / nr_producers * nr_producers;
+	for (unsigned long received = 0; received < total;) {
+		size_t n = use_mpsc ? mpsc_wait_batch(mpsc, items, WORKER_BATCH) :
+				   locked_pop_batch(&locked, items, WORKER_BATCH);
+		for (size_t i = 0; i < n; i++) {
+			unsigned long id = items[i] >> PRODUCER_SHIFT;
+			unsigned long seq = items[i] & ((1ul << PRODUCER_SHIFT) - 1);
+			DIE(seq != expected[id]++, "items of a producer out of order");
+		}
+		received += n;
+	}
+	double elapsed = bench_now() - start;
+
+	for (int i = 0; i < nr_producers; i++)
+		pthread_join(producers[i].thread, NULL);
+	free(producers);
+	free(expected);
+	if (use_mpsc) {
+		mpsc_free(mpsc);
+	} else {
+		q_free(locked.q);
+		pthread_mutex_destroy(&locked.lock);
+		pthread_cond_destroy(&locked.not_empty);
+	}
+	return total / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+	int max_producers = argc > 1 ? atoi(argv[1]) : DEFAULT_PRODUCERS;
+	long nr_items = argc > 2 ? atol(argv[2]) : DEFAULT_ITEMS;
+	DIE(max_producers < 1 || nr_items < max_producers, "invalid arguments");
+
+	printf("%10s %12s %12s\n", "producers", "mpsc Mops/s", "mutex Mops/s");
+	for (int p = 1; p <= max_producers; p *= 2)
+		printf("%10d %12.2f %12.2f\n", p, run(p, nr_items, true),
+			   run(p, nr_items, false));
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark pentru parsarea inputului: se genereaza un fisier temporar de
+ * requesturi, ca cele din teste (EDIT-uri, unele cu continut pe mai multe
+ * linii, GET-uri si cateva ADD_SERVER / REMOVE_SERVER), care este parsat
+ * de mai multe ori cu fgets si cu mmap, ca in main.c; pentru fiecare parser
+ * se afiseaza cea mai buna rulare, iar cele doua trebuie sa citeasca
+ * aceleasi requesturi
+ *
+ * utilizare: parser [nr. de requesturi] [nr. de rulari]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_utils.h"
+#include "request_parser.h"
+
+#define DEFAULT_REQUESTS 1000000
+#define DEFAULT_ROUNDS 5
+#define NR_DOCS 10000
+// lungimea maxima a unui continut generat, in cuvinte
+#define MAX_WORDS 32
+
+static const char *words[] = { "lorem", "ipsum", "dolor", "sit", "amet" };
+
+/* functie care scrie in fisier un continut aleator intre ghilimele; unul
+ * din 8 continuturi se intinde pe mai multe linii
+*/
+static void write_content(FILE *f, unsigned int *seed) {
+	int nr_words = 1 + bench_rand(seed) % MAX_WORDS;
+	bool multiline = bench_rand(seed) % 8 == 0;
+	fputc('"', f);
+	for (int i = 0; i < nr_words; i++) {
+		if (i)
+			fputc(multiline && i % 8 == 0 ? '\n' : ' ', f);
+		fputs(words[bench_rand(seed) % 5], f);
+	}
+	fputc('"', f);
+}
+
+/* functie care genereaza un fisier temporar cu nr_requests requesturi,
+ * precedate de linia cu numarul lor, ca inputul temei
+*/
+static FILE *generate_input(int nr_requests) {
+	FILE *f = tmpfile();
+	DIE(f == NULL, "tmpfile failed");
+
+	fprintf(f, "%d\n", nr_requests);
+	unsigned int seed = 1;
+	int next_id = 1;
+	for (int i = 0; i < nr_requests; i++) {
+		unsigned int r = bench_rand(&seed) % 100;
+		unsigned int doc = bench_rand(&seed) % NR_DOCS;
+		if (r == 0) {
+			fprintf(f, "ADD_SERVER %d %u\n", next_id++,
+					1 + bench_rand(&seed) % 100);
+		} else if (r == 1) {
+			fprintf(f, "REMOVE_SERVER %d\n", next_id - 1);
+		} else if (r < 50) {
+			fprintf(f, "EDIT \"doc_%u\" ", doc);
+			write_content(f, &seed);
+			fputc('\n', f);
+		} else {
+			fprintf(f, "GET \"doc_%u\"\n", doc);
+		}
+	}
+	fflush(f);
+	return f;
+}
+
+/* functie care adauga un request la o suma de control, ca cele doua
+ * parsere sa poata fi comparate
+*/
+static unsigned long checksum(unsigned long sum, parsed_request *req) {
+	sum = sum * 31 + req->type;
+	if (req->type == ADD_SERVER || req->type == REMOVE_SERVER)
+		return sum * 31 + req->server_id;
+	sum = sum * 31 + strlen(req->doc_name);
+	if (req->doc_content)
+		sum = sum * 31 + strlen(req->doc_content);
+	return sum;
+}
+
+/* functie care parseaza tot fisierul, cu mmap sau cu fgets, si returneaza
+ * durata parsarii; numele si continuturile citite cu fgets sunt eliberate,
+ * ca in modul serial
+*/
+static double parse_all(FILE *f, int nr_requests, bool use_mmap,
+						unsigned long *sum) {
+	char buffer[REQUEST_LENGTH + 1];
+	rewind(f);
+	DIE(fgets(buffer, sizeof(buffer), f) == NULL, "empty input file");
+
+	mapped_input mapped;
+	request_parser parser = {
+		.input_file = f,
+		.buffer = buffer,
+		.mapped = use_mmap ? &mapped : NULL,
+		.requests_num = nr_requests,
+	};
+
+	double start = bench_now();
+	if (use_mmap)
+		map_input(f, &mapped);
+	parsed_request req;
+	*sum = 0;
+	for (int i = 0; i < nr_requests; i++) {
+		parse_request(&parser, &req);
+		*sum = checksum(*sum, &req);
+		if (!use_mmap && req.type != ADD_SERVER &&
+			req.type != REMOVE_SERVER) {
+			free(req.doc_name);
+			free(req.doc_content);
+		}
+	}
+	if (use_mmap)
+		unmap_input(&mapped);
+	return bench_now() - start;
+}
+
+int main(int argc, char *argv[]) {
+	int nr_requests = argc > 1 ? atoi(argv[1]) : DEFAULT_REQUESTS;
+	int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+	DIE(nr_requests < 1 || rounds < 1, "invalid arguments");
+
+	FILE *f = generate_input(nr_requests);
+	long size = ftell(f);
+
+	printf("%d requests, %.1f MB\n", nr_requests, size / 1e6);
+	printf("%-6s %12s %10s\n", "parser", "Mreq/s", "MB/s");
+	unsigned long sums[2];
+	for (int use_mmap = 0; use_mmap < 2; use_mmap++) {
+		double best = 0;
+		for (int i = 0; i < rounds; i++) {
+			double elapsed = parse_all(f, nr_requests, use_mmap,
+									   &sums[use_mmap]);
+			if (i == 0 || elapsed < best)
+				best = elapsed;
+		}
+		printf("%-6s %12.2f %10.1f\n", use_mmap ? "mmap" : "fgets",
+			   nr_requests / best / 1e6, size / best / 1e6);
+	}
+	DIE(sums[0] != sums[1], "the parsers read different requests");
+
+	fclose(f);
+	return 0;
+}
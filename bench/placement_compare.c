@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark care compara strategiile de plasare: pentru fiecare strategie se
+ * adauga un numar de servere si se plaseaza aceleasi documente, apoi se
+ * masoara durata unei cautari, echilibrul (maximul si minimul documentelor
+ * per server, raportate la medie) si procentul de documente mutate la
+ * adaugarea celui de-al n + 1-lea server si la eliminarea unuia ales
+ * aleator; o strategie ideala muta 1 / (n + 1) din documente de fiecare data
+ * jump, rendezvous si Maglev folosesc functiile din placement.c, iar hash
+ * ring-ul este refacut aici cu etichetele load balancer-ului, cate
+ * VNODES_REPLICAS per server
+ *
+ * utilizare: placement_compare [nr. de servere] [nr. de documente]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+
+#define DEFAULT_SERVERS 100
+#define DEFAULT_DOCS 1000000
+#define FIRST_ID 1
+
+// hash ring-ul, cu etichetele sortate crescator dupa hash
+typedef struct bench_ring {
+	ring_point *points;
+	int nr_points;
+} bench_ring;
+
+/* functie care compara doua etichete de pe ring dupa hash
+*/
+static int compare_points(const void *a, const void *b) {
+	const ring_point *x = a, *y = b;
+	if (x->hash != y->hash)
+		return x->hash < y->hash ? -1 : 1;
+	return x->slot - y->slot;
+}
+
+/* functie care adauga etichetele unui server pe ring, ca load balancer-ul
+ * pentru id-uri mai mici decat REPLICA_LABEL_STEP
+*/
+static void ring_add(bench_ring *ring, int slot, int server_id) {
+	ring->points = realloc(ring->points, (ring->nr_points + VNODES_REPLICAS) *
+						   sizeof(ring_point));
+	DIE(ring->points == NULL, "Failed to allocate memory\n");
+	for (int r = 0; r < VNODES_REPLICAS; r++) {
+		int label = r * REPLICA_LABEL_STEP + server_id;
+		ring->points[ring->nr_points++] = (ring_point){ hash_uint(&label),
+														slot };
+	}
+	qsort(ring->points, ring->nr_points, sizeof(ring_point), compare_points);
+}
+
+static void ring_remove(bench_ring *ring, int slot) {
+	int n = 0;
+	for (int i = 0; i < ring->nr_points; i++)
+		if (ring->points[i].slot != slot)
+			ring->points[n++] = ring->points[i];
+	ring->nr_points = n;
+}
+
+/* functie care returneaza slotul primei etichete cu hashul mai mare decat
+ * cel al documentului, revenind la prima eticheta
+*/
+static int ring_locate(bench_ring *ring, unsigned int hash) {
+	int lo = 0, len = ring->nr_points;
+	while (len > 0) {
+		int half = len / 2;
+		if (ring->points[lo + half].hash <= hash) {
+			lo += half + 1;
+			len -= half + 1;
+		} else {
+			len = half;
+		}
+	}
+	return ring->points[lo == ring->nr_points ? 0 : lo].slot;
+}
+
+// o strategie: hash ring-ul de mai sus sau o plasare din placement.c
+typedef struct strategy {
+	placement_type type;
+	bench_ring ring;
+	placement *p;
+} strategy;
+
+static void strategy_add(strategy *st, int slot, int server_id) {
+	if (st->p)
+		placement_add_server(st->p, slot, server_id);
+	else
+		ring_add(&st->ring, slot, server_id);
+}
+
+static void strategy_remove(strategy *st, int slot) {
+	if (st->p)
+		placement_remove_server(st->p, slot);
+	else
+		ring_remove(&st->ring, slot);
+}
+
+static int strategy_locate(strategy *st, unsigned int hash) {
+	return st->p ? placement_locate(st->p, hash) :
+		   ring_locate(&st->ring, hash);
+}
+
+/* functie care plaseaza toate documentele, retinand slotul fiecaruia in
+ * owners, si returneaza cate si-au schimbat slotul
+*/
+static int place_docs(strategy *st, unsigned int *hashes, int nr_docs,
+					  int *owners) {
+	int moved = 0;
+	for (int i = 0; i < nr_docs; i++) {
+		int slot = strategy_locate(st, hashes[i]);
+		moved += slot != owners[i];
+		owners[i] = slot;
+	}
+	return moved;
+}
+
+/* functie care ruleaza masuratorile pentru o strategie
+*/
+static void compare(placement_type type, int nr_servers, unsigned int *hashes,
+					int nr_docs) {
+	strategy st = { .type = type };
+	if (type != PLACEMENT_RING)
+		st.p = init_placement(type);
+	for (int i = 0; i < nr_servers; i++)
+		strategy_add(&st, i, FIRST_ID + i);
+
+	int *owners = malloc(nr_docs * sizeof(int));
+	int *load = calloc(nr_servers + 1, sizeof(int));
+	DIE(owners == NULL || load == NULL, "Failed to allocate memory\n");
+	for (int i = 0; i < nr_docs; i++)
+		owners[i] = -1;
+
+	double start = bench_now();
+	place_docs(&st, hashes, nr_docs, owners);
+	double lookup = (bench_now() - start) * 1e9 / nr_docs;
+
+	for (int i = 0; i < nr_docs; i++)
+		load[owners[i]]++;
+	int max_load = 0, min_load = nr_docs;
+	for (int i = 0; i < nr_servers; i++) {
+		if (load[i] > max_load)
+			max_load = load[i];
+		if (load[i] < min_load)
+			min_load = load[i];
+	}
+	double mean = (double)nr_docs / nr_servers;
+
+	// serverul nou primeste urmatorul slot, iar cel eliminat este aleator
+	strategy_add(&st, nr_servers, FIRST_ID + nr_servers);
+	int moved_add = place_docs(&st, hashes, nr_docs, owners);
+	unsigned int seed = 1;
+	strategy_remove(&st, bench_rand(&seed) % (nr_servers + 1));
+	int moved_remove = place_docs(&st, hashes, nr_docs, owners);
+
+	printf("%-12s %10.1f %10.3f %10.3f %10.2f %10.2f\n",
+		   placement_name(type), lookup, max_load / mean, min_load / mean,
+		   100.0 * moved_add / nr_docs, 100.0 * moved_remove / nr_docs);
+
+	free(owners);
+	free(load);
+	free(st.ring.points);
+	if (st.p)
+		free_placement(&st.p);
+}
+
+int main(int argc, char *argv[]) {
+	int nr_servers = argc > 1 ? atoi(argv[1]) : DEFAULT_SERVERS;
+	int nr_docs = argc > 2 ? atoi(argv[2]) : DEFAULT_DOCS;
+	DIE(nr_servers < 1 || nr_servers + FIRST_ID >= REPLICA_LABEL_STEP ||
+		nr_docs < 1, "invalid arguments");
+
+	// pozitiile documentelor, calculate ca in load balancer; numele sunt
+	// aleatoare, deoarece hash_string nu amesteca numele consecutive
+	// ("doc_1", "doc_2", ...), care ar cadea pe cateva arce ale ring-ului
+	unsigned int *hashes = malloc(nr_docs * sizeof(unsigned int));
+	DIE(hashes == NULL, "Failed to allocate memory\n");
+	char name[DOC_NAME_LENGTH];
+	unsigned int seed = 1;
+	for (int i = 0; i < nr_docs; i++) {
+		unsigned int high = bench_rand(&seed);
+		snprintf(name, sizeof(name), "doc_%08x%08x", high,
+				 bench_rand(&seed));
+		hashes[i] = hash_string(name);
+	}
+
+	printf("%d servers, %d documents; ideal moves: %.2f%% on add, "
+		   "%.2f%% on remove\n", nr_servers, nr_docs,
+		   100.0 / (nr_servers + 1), 100.0 / (nr_servers + 1));
+	printf("%-12s %10s %10s %10s %10s %10s\n", "placement", "ns/lookup",
+		   "max/mean", "min/mean", "% add", "% remove");
+	for (int type = 0; type < PLACEMENT_TYPES; type++)
+		compare(type, nr_servers, hashes, nr_docs);
+
+	free(hashes);
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark pentru hash ring: se adauga servere cu VNODES_REPLICAS etichete
+ * fiecare, pana la peste 10000 de etichete pe ring, si se trimit GET-uri
+ * pentru documente inexistente, care sunt doar rutate si cautate in baza de
+ * date a serverului; cautarea binara pe ring tine durata aproape constanta
+ *
+ * utilizare: ring_lookup [nr. maxim de servere] [nr. de GET-uri]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+
+#define DEFAULT_MAX_SERVERS 30000
+#define DEFAULT_GETS 1000000
+
+/* functie care masoara, pentru un ring cu nr_servers servere, durata medie
+ * a unei adaugari de server si a unui GET, in ns
+*/
+static void ring_latency(int nr_servers, int nr_gets) {
+	load_balancer *main = bench_load_balancer(true);
+
+	double start = bench_now();
+	for (int id = 1; id <= nr_servers; id++)
+		loader_add_server(main, id, 1);
+	double add_time = bench_now() - start;
+
+	char name[DOC_NAME_LENGTH];
+	unsigned int seed = 1;
+	start = bench_now();
+	for (int i = 0; i < nr_gets; i++) {
+		snprintf(name, sizeof(name), "doc_%u", bench_rand(&seed));
+		bench_request(main, name, NULL);
+	}
+	double get_time = bench_now() - start;
+
+	printf("%8d %12d %12.1f %12.1f\n", nr_servers, main->nr_tags,
+		   add_time * 1e9 / nr_servers, get_time * 1e9 / nr_gets);
+	bench_free_load_balancer(&main);
+}
+
+int main(int argc, char *argv[]) {
+	int max_servers = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_SERVERS;
+	int nr_gets = argc > 2 ? atoi(argv[2]) : DEFAULT_GETS;
+	DIE(max_servers < 1 || max_servers >= REPLICA_LABEL_STEP || nr_gets < 1,
+		"invalid arguments");
+
+	printf("%8s %12s %12s %12s\n", "servers", "ring points", "ns/ADD",
+		   "ns/GET");
+	for (int nr_servers = 10; nr_servers < max_servers; nr_servers *= 10)
+		ring_latency(nr_servers, nr_gets);
+	ring_latency(max_servers, nr_gets);
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+/* benchmark pentru sloturile serverelor: se adauga pana la 100000 de
+ * servere, cu id-uri care depasesc vechiul MAX_SERVERS, se elimina jumatate
+ * dintre ele intr-o ordine aleatoare si se adauga altele in locul lor, care
+ * trebuie sa refoloseasca sloturile eliberate
+ *
+ * utilizare: server_slots [nr. maxim de servere]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench_utils.h"
+
+#define DEFAULT_MAX_SERVERS 100000
+// id-urile incep peste 99999, unde se termina vechiul vector tag_to_index
+#define FIRST_ID 100000
+
+/* functie care afiseaza durata medie a unei adaugari si a unei eliminari
+ * de server, pentru un sistem cu nr_servers servere
+*/
+static void slot_latency(int nr_servers) {
+	load_balancer *main = bench_load_balancer(false);
+	int *ids = malloc(nr_servers * sizeof(int));
+	DIE(ids == NULL, "Failed to allocate memory\n");
+
+	double start = bench_now();
+	for (int i = 0; i < nr_servers; i++) {
+		ids[i] = FIRST_ID + 3 * i;
+		loader_add_server(main, ids[i], 1);
+	}
+	double add_time = bench_now() - start;
+
+	// se elimina jumatate din servere, intr-o ordine aleatoare
+	unsigned int seed = 1;
+	for (int i = nr_servers - 1; i > 0; i--) {
+		int j = bench_rand(&seed) % (i + 1);
+		int aux = ids[i];
+		ids[i] = ids[j];
+		ids[j] = aux;
+	}
+	int nr_removed = nr_servers / 2;
+	start = bench_now();
+	for (int i = 0; i < nr_removed; i++)
+		loader_remove_server(main, ids[i]);
+	double remove_time = bench_now() - start;
+
+	// serverele noi ocupa sloturile eliberate
+	for (int i = 0; i < nr_removed; i++)
+		loader_add_server(main, ids[i] + 1, 1);
+	DIE(main->nr_slots != nr_servers, "freed slots were not reused");
+
+	printf("%8d %12.1f %12.1f\n", nr_servers, add_time * 1e9 / nr_servers,
+		   nr_removed ? remove_time * 1e9 / nr_removed : 0);
+	free(ids);
+	bench_free_load_balancer(&main);
+}
+
+int main(int argc, char *argv[]) {
+	int max_servers = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_SERVERS;
+	DIE(max_servers < 1, "invalid arguments");
+
+	printf("%8s %12s %12s\n", "servers", "ns/ADD", "ns/REMOVE");
+	for (int nr_servers = 1000; nr_servers < max_servers; nr_servers *= 10)
+		slot_latency(nr_servers);
+	slot_latency(max_servers);
+	return 0;
+}
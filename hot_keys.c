@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "hot_keys.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+hot_keys *init_hot_keys(void) {
+	hot_keys *hk = malloc(sizeof(hot_keys));
+	DIE(hk == NULL, "Failed to allocate memory\n");
+	hk->counters = calloc(HOT_SKETCH_DEPTH * HOT_SKETCH_WIDTH,
+						  sizeof(unsigned int));
+	DIE(hk->counters == NULL, "Failed to allocate memory\n");
+	hk->window = 0;
+	hk->nr_docs = 0;
+	// cheile indexului sunt numele retinute in docs
+	hk->index = ht_create_ref(2 * MAX_HOT_DOCS, hash_string, compare_function);
+	return hk;
+}
+
+/* functie care injumatateste toate contoarele si estimarile documentelor
+ * fierbinti
+*/
+static void hot_keys_age(hot_keys *hk) {
+	for (int i = 0; i < HOT_SKETCH_DEPTH * HOT_SKETCH_WIDTH; i++)
+		hk->counters[i] >>= 1;
+	for (int i = 0; i < hk->nr_docs; i++)
+		hk->docs[i].count >>= 1;
+	hk->window = 0;
+}
+
+unsigned int hot_keys_count(hot_keys *hk, char *doc_name) {
+	// pozitiile de pe randuri sunt h1 + i * h2 (double hashing); h2 este
+	// impar, deci pozitiile unui document difera pe fiecare rand
+	unsigned int h1 = hash_string(doc_name);
+	unsigned int h2 = hash_uint(&h1) | 1;
+	unsigned int *cells[HOT_SKETCH_DEPTH];
+	unsigned int min = UINT32_MAX;
+	for (int i = 0; i < HOT_SKETCH_DEPTH; i++) {
+		unsigned int col = (h1 + i * h2) & (HOT_SKETCH_WIDTH - 1);
+		cells[i] = &hk->counters[i * HOT_SKETCH_WIDTH + col];
+		if (*cells[i] < min)
+			min = *cells[i];
+	}
+
+	// doar contoarele egale cu minimul cresc; celelalte numara deja si
+	// alte documente
+	for (int i = 0; i < HOT_SKETCH_DEPTH; i++)
+		if (*cells[i] == min)
+			(*cells[i])++;
+
+	if (++hk->window == HOT_SKETCH_WINDOW)
+		hot_keys_age(hk);
+	return min + 1;
+}
+
+hot_doc *hot_keys_find(hot_keys *hk, char *doc_name) {
+	return ht_get(hk->index, doc_name);
+}
+
+hot_doc *hot_keys_coldest(hot_keys *hk) {
+	if (hk->nr_docs < MAX_HOT_DOCS)
+		return NULL;
+	hot_doc *coldest = &hk->docs[0];
+	for (int i = 1; i < hk->nr_docs; i++)
+		if (hk->docs[i].count < coldest->count)
+			coldest = &hk->docs[i];
+	return coldest;
+}
+
+hot_doc *hot_keys_admit(hot_keys *hk, char *doc_name, unsigned int count) {
+	DIE(hk->nr_docs == MAX_HOT_DOCS, "too many hot documents");
+	hot_doc *doc = &hk->docs[hk->nr_docs++];
+	doc->doc_name = copy_string(doc_name, DOC_NAME_LENGTH);
+	doc->count = count;
+	doc->nr_replicas = 0;
+	doc->next = 0;
+	ht_put(hk->index, doc->doc_name, 0, doc, 0);
+	return doc;
+}
+
+void hot_keys_evict(hot_keys *hk, hot_doc *doc) {
+	ht_remove_entry(hk->index, doc->doc_name);
+	free(doc->doc_name);
+
+	// ultima intrare ia locul celei eliminate
+	hot_doc *last = &hk->docs[--hk->nr_docs];
+	if (doc != last) {
+		*doc = *last;
+		ht_put(hk->index, doc->doc_name, 0, doc, 0);
+	}
+}
+
+void free_hot_keys(hot_keys **hk) {
+	for (int i = 0; i < (*hk)->nr_docs; i++)
+		free((*hk)->docs[i].doc_name);
+	ht_free((*hk)->index);
+	free((*hk)->counters);
+	free(*hk);
+	*hk = NULL;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef HOT_KEYS_H
+#define HOT_KEYS_H
+
+#include "list_queue_hashtable_functions.h"
+
+// dimensiunile count-min sketch-ului: randuri si contoare pe rand (putere
+// a lui 2)
+#define HOT_SKETCH_DEPTH 4
+#define HOT_SKETCH_WIDTH 4096
+// numarul de requesturi dupa care toate contoarele sunt injumatatite, ca
+// documentele care nu mai sunt accesate sa se raceasca
+#define HOT_SKETCH_WINDOW (16 * HOT_SKETCH_WIDTH)
+// numarul de accesari estimate de la care un document devine fierbinte
+#define HOT_KEY_THRESHOLD 64
+// numarul maxim de documente fierbinti urmarite deodata
+#define MAX_HOT_DOCS 64
+// numarul maxim de replici ale unui document fierbinte
+#define MAX_HOT_REPLICAS 8
+
+/* un document fierbinte si replicile lui read-only, tinute de urmatoarele
+ * servere de pe ring
+*/
+typedef struct hot_doc {
+	char *doc_name;
+	// estimarea accesarilor la ultimul request pentru document
+	unsigned int count;
+	// sloturile serverelor care tin o replica; nr_replicas este 0 cat timp
+	// replicile nu sunt valide
+	int replicas[MAX_HOT_REPLICAS];
+	int nr_replicas;
+	// urmatoarea copie care raspunde la un GET, 0 fiind proprietarul
+	unsigned int next;
+} hot_doc;
+
+typedef struct hot_keys {
+	// contoarele sketch-ului, HOT_SKETCH_DEPTH randuri a cate
+	// HOT_SKETCH_WIDTH
+	unsigned int *counters;
+	// requesturile numarate de la ultima injumatatire
+	unsigned int window;
+	hot_doc docs[MAX_HOT_DOCS];
+	int nr_docs;
+	// index dupa nume peste documentele fierbinti
+	hashtable_t *index;
+} hot_keys;
+
+hot_keys *init_hot_keys(void);
+
+/**
+ * hot_keys_count() - Counts one request for a document in the count-min
+ *      sketch and returns its estimated number of requests. Only the
+ *      smallest counters of the document are incremented (conservative
+ *      update). Every HOT_SKETCH_WINDOW requests, all counts are halved.
+ */
+unsigned int hot_keys_count(hot_keys *hk, char *doc_name);
+
+/**
+ * hot_keys_find() - Returns the hot entry of a document, or NULL if the
+ *      document is not hot.
+ */
+hot_doc *hot_keys_find(hot_keys *hk, char *doc_name);
+
+/**
+ * hot_keys_coldest() - Returns the hot entry with the smallest count, or
+ *      NULL if fewer than MAX_HOT_DOCS documents are hot.
+ */
+hot_doc *hot_keys_coldest(hot_keys *hk);
+
+/**
+ * hot_keys_admit() - Makes a document hot, without replicas. There must
+ *      be room for it: the coldest entry is evicted first by the caller.
+ */
+hot_doc *hot_keys_admit(hot_keys *hk, char *doc_name, unsigned int count);
+
+/**
+ * hot_keys_evict() - Removes a hot entry. Pointers to other entries may be
+ *      invalidated.
+ */
+void hot_keys_evict(hot_keys *hk, hot_doc *doc);
+
+void free_hot_keys(hot_keys **hk);
+
+#endif /* HOT_KEYS_H */
@@ -6,6 +6,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "constants.h"
 #include "server.h"
@@ -75,9 +78,11 @@ void dll_remove_node(dll_t *dll, dll_node_t *node) {
 	if (node == dll->head) {
 		// daca nodul este capul listei
 		dll->head = node->next;
-		// se repara legatura
+		// se repara legatura; daca nodul era singurul, lista ramane goala
 		if (dll->head != NULL)
 			dll->head->prev = NULL;
+		else
+			dll->tail = NULL;
 		dll->size--;
 		return;
 	} else if (node == dll->tail) {
@@ -96,6 +101,41 @@ void dll_remove_node(dll_t *dll, dll_node_t *node) {
 	}
 }
 
+/* functie care adauga la finalul listei un nod deja alocat, scos dintr-o
+ * alta lista, fara a-i copia datele
+*/
+void dll_link_node(dll_t *list, dll_node_t *node) {
+	node->next = NULL;
+	node->prev = list->tail;
+	if (list->tail)
+		list->tail->next = node;
+	else
+		list->head = node;
+	list->tail = node;
+	list->size++;
+}
+
+/* functie care muta toate nodurile listei src la finalul listei dst, in
+ * O(1); lista src ramane goala
+*/
+void dll_splice(dll_t *dst, dll_t *src) {
+	if (src->head == NULL)
+		return;
+
+	if (dst->tail) {
+		dst->tail->next = src->head;
+		src->head->prev = dst->tail;
+	} else {
+		dst->head = src->head;
+	}
+	dst->tail = src->tail;
+	dst->size += src->size;
+
+	src->head = NULL;
+	src->tail = NULL;
+	src->size = 0;
+}
+
 /* functie care elibereeza memoria unei perechi cheie-valoare
 */
 void key_val_free_function(void *data) {
@@ -114,8 +154,68 @@ void doc_t_free_function(void *data) {
 		free(((doc_t *)data)->doc_content);
 }
 
-/* functie care creeaza un hashtable, cu maximum hmax buckets, ce va contine
- * pointeri la functii de hash, comparare de chei si eliberare de memorie
+/* functie care amesteca hashul unei chei (hashing Fibonacci); bitii cei mai
+ * semnificativi dau slotul de start, iar cei mai putin semnificativi 7 biti
+ * dau octetul de control
+*/
+static inline unsigned int ht_mix(unsigned int hash) {
+	return hash * 0x9E3779B1u;
+}
+
+/* functie care returneaza slotul de start al unui hash
+*/
+static inline unsigned int ht_home(hashtable_t *ht, unsigned int hash) {
+	return ht_mix(hash) >> ht->shift;
+}
+
+/* functie care seteaza octetul de control al unui slot, actualizand si
+ * copia lui de la finalul vectorului de control
+*/
+static inline void ht_set_ctrl(hashtable_t *ht, unsigned int i,
+							   unsigned char c) {
+	ht->ctrl[i] = c;
+	if (i < HT_GROUP_WIDTH)
+		ht->ctrl[ht->hmax + i] = c;
+}
+
+/* functie care returneaza masca pozitiilor dintr-un grup de HT_GROUP_WIDTH
+ * octeti de control, incepand cu ctrl, egale cu octetul c
+*/
+static inline unsigned int ht_group_match(const unsigned char *ctrl,
+										  unsigned char c) {
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < HT_GROUP_WIDTH; i++)
+		if (ctrl[i] == c)
+			mask |= 1u << i;
+	return mask;
+#endif
+}
+
+/* functie care aloca vectorii de control si de sloturi pentru un hashtable
+ * cu hmax sloturi (putere a lui 2, cel putin HT_GROUP_WIDTH)
+*/
+static void ht_alloc_slots(hashtable_t *ht, unsigned int hmax) {
+	ht->hmax = hmax;
+	ht->shift = 32;
+	while ((1u << (32 - ht->shift)) < hmax)
+		ht->shift--;
+
+	ht->ctrl = malloc(hmax + HT_GROUP_WIDTH);
+	DIE(ht->ctrl == NULL, "Failed to allocate memory\n");
+	memset(ht->ctrl, HT_EMPTY, hmax + HT_GROUP_WIDTH);
+
+	ht->slots = malloc(hmax * sizeof(ht_slot));
+	DIE(ht->slots == NULL, "Failed to allocate memory\n");
+}
+
+/* functie care creeaza un hashtable cu adresare deschisa, suficient de mare
+ * pentru hmax intrari, ce va contine pointeri la functii de hash, comparare
+ * de chei si eliberare de memorie
+ * hashtable-ul pastreaza copii ale cheilor si valorilor inserate
 */
 hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
 					   int (*compare_function)(void *, void *),
@@ -123,55 +223,214 @@ hashtable_t *ht_create(unsigned int hmax, unsigned int (*hash_function)(void *),
 	// se aloca memorie pentru hashtable si se initializeaza campurile
 	hashtable_t *hashtable = malloc(1 * sizeof(hashtable_t));
 	DIE(hashtable == NULL, "Failed to allocate memory\n");
-	hashtable->buckets = malloc(hmax * sizeof(dll_t *));
-	DIE(hashtable->buckets == NULL, "Failed to allocate memory\n");
-	hashtable->hmax = hmax;
+
+	// nr. de sloturi este cea mai mica putere a lui 2 la care hmax intrari
+	// nu depasesc factorul maxim de incarcare
+	unsigned int slots = HT_GROUP_WIDTH;
+	while (slots / HT_MAX_LOAD_DEN * HT_MAX_LOAD_NUM < hmax)
+		slots *= 2;
+	ht_alloc_slots(hashtable, slots);
+
 	hashtable->size = 0;
+	hashtable->owns_entries = true;
 	hashtable->hash_function = hash_function;
 	hashtable->compare_function = compare_function;
 	hashtable->key_val_free_function = key_val_free_function;
+	return hashtable;
+}
 
-	// se initialieaza fiecare bucket
-	for (unsigned int i = 0; i < hmax; i++)
-		hashtable->buckets[i] = dll_create(sizeof(info));
+/* functie care creeaza un hashtable ce retine direct pointerii la cheile si
+ * valorile inserate, fara a le copia sau elibera
+ * cheia trebuie sa ramana valida cat timp intrarea se afla in hashtable
+*/
+hashtable_t *ht_create_ref(unsigned int hmax,
+						   unsigned int (*hash_function)(void *),
+						   int (*compare_function)(void *, void *)) {
+	hashtable_t *hashtable = ht_create(hmax, hash_function, compare_function,
+									   NULL);
+	hashtable->owns_entries = false;
 	return hashtable;
 }
 
+/* functie care returneaza indexul slotului ce contine cheia data ca
+ * parametru sau -1 daca cheia nu se afla in hashtable
+ * se compara cate un grup de octeti de control o data, iar cautarea se
+ * opreste la primul grup care contine un slot gol
+*/
+static int ht_find_slot(hashtable_t *ht, void *key, unsigned int hash) {
+	unsigned int mask = ht->hmax - 1;
+	unsigned char tag = ht_mix(hash) & HT_TAG_MASK;
+	unsigned int pos = ht_home(ht, hash);
+
+	while (1) {
+		unsigned int match = ht_group_match(ht->ctrl + pos, tag);
+		while (match) {
+			unsigned int i = (pos + __builtin_ctz(match)) & mask;
+			if (ht->slots[i].hash == hash &&
+				ht->compare_function(ht->slots[i].pair.key, key) == 0)
+				return i;
+			match &= match - 1;
+		}
+		if (ht_group_match(ht->ctrl + pos, HT_EMPTY))
+			return -1;
+		pos = (pos + HT_GROUP_WIDTH) & mask;
+	}
+}
+
+/* functie care plaseaza o intrare in primul slot gol de la slotul ei de
+ * start (sondare liniara) si returneaza indexul slotului
+*/
+static unsigned int ht_place(hashtable_t *ht, unsigned int hash) {
+	unsigned int mask = ht->hmax - 1;
+	unsigned int pos = ht_home(ht, hash);
+
+	unsigned int empty;
+	while (!(empty = ht_group_match(ht->ctrl + pos, HT_EMPTY)))
+		pos = (pos + HT_GROUP_WIDTH) & mask;
+
+	unsigned int i = (pos + __builtin_ctz(empty)) & mask;
+	ht_set_ctrl(ht, i, ht_mix(hash) & HT_TAG_MASK);
+	ht->slots[i].hash = hash;
+	return i;
+}
+
+/* functie care dubleaza numarul de sloturi ale unui hashtable si
+ * redistribuie intrarile existente, folosind hashurile pastrate
+*/
+static void ht_resize(hashtable_t *ht) {
+	unsigned char *old_ctrl = ht->ctrl;
+	ht_slot *old_slots = ht->slots;
+	unsigned int old_hmax = ht->hmax;
+
+	ht_alloc_slots(ht, old_hmax * 2);
+	for (unsigned int i = 0; i < old_hmax; i++) {
+		if (old_ctrl[i] == HT_EMPTY)
+			continue;
+		unsigned int j = ht_place(ht, old_slots[i].hash);
+		ht->slots[j].pair = old_slots[i].pair;
+	}
+	free(old_ctrl);
+	free(old_slots);
+}
+
+/* functie care elibereaza cheia si valoarea unei intrari, daca acestea
+ * apartin hashtable-ului
+*/
+static void ht_free_pair(hashtable_t *ht, info *pair) {
+	if (!ht->owns_entries)
+		return;
+	if (ht->key_val_free_function)
+		ht->key_val_free_function(pair);
+	else
+		// se elibereaza doar cheia, valoarea fiind detinuta de
+		// structura care a creat hashtable-ul
+		free(pair->key);
+}
+
+/* functie care adauga o pereche cheie-valoare in hashtable; daca cheia
+ * exista deja, valoarea este inlocuita
+ * hashtable-ul isi dubleaza numarul de sloturi cand factorul de incarcare
+ * ar depasi HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN
+*/
+void ht_put(hashtable_t *ht, void *key, unsigned int key_size,
+			void *value, unsigned int value_size) {
+	unsigned int hash = ht->hash_function(key);
+	int i = ht_find_slot(ht, key, hash);
+	if (i >= 0) {
+		// cheia exista deja, se inlocuieste valoarea
+		info *pair = &ht->slots[i].pair;
+		if (!ht->owns_entries) {
+			pair->value = value;
+			return;
+		}
+		free(pair->value);
+		pair->value = malloc(value_size);
+		DIE(pair->value == NULL, "Failed to allocate memory\n");
+		memcpy(pair->value, value, value_size);
+		return;
+	}
+
+	if ((ht->size + 1) * HT_MAX_LOAD_DEN > ht->hmax * HT_MAX_LOAD_NUM)
+		ht_resize(ht);
+
+	info *pair = &ht->slots[ht_place(ht, hash)].pair;
+	if (!ht->owns_entries) {
+		pair->key = key;
+		pair->value = value;
+	} else {
+		pair->key = malloc(key_size);
+		DIE(pair->key == NULL, "Failed to allocate memory\n");
+		memcpy(pair->key, key, key_size);
+		pair->value = malloc(value_size);
+		DIE(pair->value == NULL, "Failed to allocate memory\n");
+		memcpy(pair->value, value, value_size);
+	}
+	ht->size++;
+}
+
+/* functie care returneaza valoarea asociata unei chei sau NULL daca cheia
+ * nu se afla in hashtable
+*/
+void *ht_get(hashtable_t *ht, void *key) {
+	int i = ht_find_slot(ht, key, ht->hash_function(key));
+	if (i < 0)
+		return NULL;
+	return ht->slots[i].pair.value;
+}
+
 /* functie care verifica daca o cheie, data ca parametru, se afla in hashtable
 * functia va returna 1 daca cheia este prezenta in hashtable si 0 in caz contrar
 */
 int ht_has_key(hashtable_t *ht, void *key) {
-	unsigned int hash = ht->hash_function(key);
-	hash %= ht->hmax;
+	return ht_find_slot(ht, key, ht->hash_function(key)) >= 0;
+}
 
-	dll_node_t *aux = ht->buckets[hash]->head;
+/* functie care elimina din hashtable intrarea asociata unei chei
+ * nu se folosesc marcaje de stergere: intrarile care urmeaza in acelasi
+ * lant de sondare sunt mutate inapoi, daca slotul lor de start permite
+*/
+void ht_remove_entry(hashtable_t *ht, void *key) {
+	int found = ht_find_slot(ht, key, ht->hash_function(key));
+	if (found < 0)
+		return;
+
+	unsigned int mask = ht->hmax - 1;
+	unsigned int i = found;
+	ht_free_pair(ht, &ht->slots[i].pair);
+	ht_set_ctrl(ht, i, HT_EMPTY);
+	ht->size--;
 
-	while (aux != NULL) {
-		if (ht->compare_function(((info *)(aux->data))->key, key) == 0)
-			return 1;
-		aux = aux->next;
+	for (unsigned int j = (i + 1) & mask; ht->ctrl[j] != HT_EMPTY;
+		 j = (j + 1) & mask) {
+		unsigned int home = ht_home(ht, ht->slots[j].hash);
+		// intrarea din j poate ocupa golul din i daca slotul ei de start
+		// nu se afla intre i (exclusiv) si j (inclusiv)
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			ht->slots[i] = ht->slots[j];
+			ht_set_ctrl(ht, i, ht->ctrl[j]);
+			ht_set_ctrl(ht, j, HT_EMPTY);
+			i = j;
+		}
 	}
-	return 0;
+}
+
+/* functie care returneaza memoria ocupata de structura hashtable-ului,
+ * fara cheile si valorile detinute de acesta
+*/
+size_t ht_memory_usage(hashtable_t *ht) {
+	return sizeof(hashtable_t) + ht->hmax + HT_GROUP_WIDTH +
+		   ht->hmax * sizeof(ht_slot);
 }
 
 /* functie care elibereaza memoria pentru in hashtable
 */
 void ht_free(hashtable_t *ht) {
-	for (unsigned int i = 0; i < ht->hmax; i++) {
-		dll_node_t *node = ht->buckets[i]->head;
-		while (node != NULL) {
-			dll_node_t *aux = node;
-			node = node->next;
-			// se elibereaza doar cheia deoarece pointerul catre valoare
-			// a fost eliberat odata cu lista de acces recent
-			free(((info *)aux->data)->key);
-			free(aux->data);
-			free(aux);
-		}
-		free(ht->buckets[i]);
-	}
+	for (unsigned int i = 0; i < ht->hmax; i++)
+		if (ht->ctrl[i] != HT_EMPTY)
+			ht_free_pair(ht, &ht->slots[i].pair);
 
-	free(ht->buckets);
+	free(ht->ctrl);
+	free(ht->slots);
 	free(ht);
 }
 
@@ -185,36 +444,44 @@ int compare_function(void *a, void *b) {
 	return strcmp(str_a, str_b);
 }
 
-/* functie care initializeaza coada de requesturi
-*/
-void init_request_queue(queue_t *q) {
-	// initializez fiecare camp de tipul request cu NULL
-	for (unsigned int i = 0; i < q->max_size; i++) {
-		((request *)q->buff[i])->doc_name = NULL;
-		((request *)q->buff[i])->doc_content = NULL;
-	}
-}
-
-/* functie care creeaza coada de task-uri, avand dimensiunea maxima
- * TASK_QUEUE_SIZE
+/* functie care creeaza o coada circulara cu elementele stocate direct in
+ * buffer, avand initial loc pentru max_size elemente
 */
 queue_t *q_create(unsigned int max_size, unsigned int data_size) {
 	queue_t *q = malloc(1 * sizeof(queue_t));
 	DIE(q == NULL, "Failed to allocate memory\n");
-	q->buff = malloc(max_size * sizeof(void *));
+	if (max_size == 0)
+		max_size = 1;
+	q->buff = malloc(max_size * data_size);
 	DIE(q->buff == NULL, "Failed to allocate memory\n");
-	for (unsigned int i = 0; i < max_size; i++) {
-		q->buff[i] = malloc(data_size);
-		DIE(q->buff[i] == NULL, "Failed to allocate memory\n");
-	}
 	q->data_size = data_size;
 	q->max_size = max_size;
 	q->size = 0;
+	q->high_water = 0;
 	q->read_idx = 0;
 	q->write_idx = 0;
 	return q;
 }
 
+/* functia returneaza adresa elementului de pe pozitia idx din buffer
+*/
+static void *q_slot(queue_t *q, unsigned int idx) {
+	return (char *)q->buff + (size_t)idx * q->data_size;
+}
+
+/* functia dubleaza capacitatea unei cozi pline; elementele de la inceputul
+ * bufferului (cele de dupa "intoarcere") se muta dupa ultimul element, ca
+ * ordinea lor sa ramana continua
+*/
+static void q_grow(queue_t *q) {
+	unsigned int old_size = q->max_size;
+	q->buff = realloc(q->buff, (size_t)2 * old_size * q->data_size);
+	DIE(q->buff == NULL, "Failed to allocate memory\n");
+	memcpy(q_slot(q, old_size), q->buff, (size_t)q->read_idx * q->data_size);
+	q->write_idx = old_size + q->read_idx;
+	q->max_size = 2 * old_size;
+}
+
 /* functia verifica daca o coada este goala
  * functia va returna 1 daca coada este goala si 0 in caz contrar
 */
@@ -227,7 +494,19 @@ unsigned int q_is_empty(queue_t *q) {
 /* functia returneaza primul element din coada
 */
 void *q_front(queue_t *q) {
-	return q->buff[q->read_idx];
+	return q_slot(q, q->read_idx);
+}
+
+/* functia returneaza ultimul element adaugat in coada
+*/
+void *q_back(queue_t *q) {
+	return q_slot(q, (q->write_idx + q->max_size - 1) % q->max_size);
+}
+
+/* functia returneaza al i-lea element din coada, numarand de la primul
+*/
+void *q_at(queue_t *q, unsigned int i) {
+	return q_slot(q, (q->read_idx + i) % q->max_size);
 }
 
 /* functia elimina primul element din coada
@@ -235,44 +514,35 @@ void *q_front(queue_t *q) {
 */
 int q_dequeue(queue_t *q) {
 	if (q->size) {
-		if (q->buff[q->read_idx]) {
-			free(q->buff[q->read_idx]);
-			q->buff[q->read_idx] = NULL;
-			q->read_idx = (q->read_idx + 1) % q->max_size;
-			q->size--;
-			return 1;
-		}
+		q->read_idx = (q->read_idx + 1) % q->max_size;
+		q->size--;
+		return 1;
 	}
 	return 0;
 }
 
-/* functia adauga un element in coada
- * functia va returna 1 daca s-a adaugat un element si 0 in caz contrar
+/* functia adauga un element in coada, dubland capacitatea cozii daca
+ * aceasta este plina
+ * functia va returna 1 daca s-a adaugat un element
 */
 int q_enqueue(queue_t *q, void *new_data) {
-	if (q->size <= q->max_size) {
-		if (q->buff[q->write_idx] == NULL) {
-			q->buff[q->write_idx] = malloc(q->data_size);
-			DIE(q->buff[q->write_idx] == NULL, "Failed to allocate memory\n");
-		}
-		memcpy(q->buff[q->write_idx], new_data, q->data_size);
-		q->write_idx = (q->write_idx + 1) % q->max_size;
-		q->size++;
-		return 1;
-	}
-	return 0;
+	if (q->size == q->max_size)
+		q_grow(q);
+	memcpy(q_slot(q, q->write_idx), new_data, q->data_size);
+	q->write_idx = (q->write_idx + 1) % q->max_size;
+	q->size++;
+	if (q->size > q->high_water)
+		q->high_water = q->size;
+	return 1;
 }
 
-/* functia elibereaza campurile pentru o coada de requesturi
+/* functia elibereaza campurile requesturilor aflate in coada
 */
 void free_request_queue(queue_t *q) {
-	for (unsigned int i = 0; i < q->max_size; i++) {
-		if (q->buff[i] && ((request *)q->buff[i])->doc_name &&
-			((request *)q->buff[i])->doc_content) {
-			free(((request *)q->buff[i])->doc_name);
-			if (((request *)q->buff[i])->doc_content)
-				free(((request *)q->buff[i])->doc_content);
-		}
+	for (unsigned int i = 0; i < q->size; i++) {
+		request *req = q_at(q, i);
+		free(req->doc_name);
+		free(req->doc_content);
 	}
 }
 
@@ -282,10 +552,6 @@ void q_clear(queue_t *q) {
 	// eliberez campurile requesturilor
 	free_request_queue(q);
 
-	for (unsigned int i = 0; i < q->max_size; i++) {
-		// verific daca in fiecare element din coada, exista un request
-		free(q->buff[i]);
-	}
 	q->size = 0;
 	q->read_idx = 0;
 	q->write_idx = 0;
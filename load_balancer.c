@@ -4,132 +4,384 @@
 
 #include "load_balancer.h"
 
+#include <math.h>
+#include <stdint.h>
+
 #include "list_queue_hashtable_functions.h"
 #include "server.h"
 
-/* functie care adauga, in ordine, o eticheta in vectorul de etichete
+/* functie care cauta binar, pe hash ring, primul punct cu hashul strict mai
+ * mare decat hashul dat ca parametru si returneaza indexul lui
+ * daca nu exista un astfel de punct, se returneaza array_size
 */
-void add_tag_in_order(int *tag_array, int tag, int array_size) {
-	// se calculeaza hashul etichetei de inserat
-	unsigned int tag_hash = hash_uint(&tag);
-	// se obtine pozitia pe care trebuie sa fie inserata eticheta, cautand
-	// ultima eticheta cu hashul mai mic decat cel al etichetei de inserat
-	int i = 0;
-	for (i = 0; i < array_size - 1; i++) {
-		if (hash_uint(&tag_array[i]) < tag_hash) {
-			continue;
-		} else if (hash_uint(&tag_array[i]) == tag_hash) {
-			// cautam ultima eticheta mai mica decat nr de adaugat,
-			// dar cu acelasi hash
-			while (hash_uint(&tag_array[i]) == tag_hash && tag > tag_array[i])
-				i++;
+static int ring_upper_bound(ring_point *ring, int array_size,
+							unsigned int hash) {
+	int lo = 0, len = array_size;
+	while (len > 0) {
+		int half = len / 2;
+		if (ring[lo + half].hash <= hash) {
+			lo += half + 1;
+			len -= half + 1;
 		} else {
-			// s-a gasit pozitia
-			break;
+			len = half;
 		}
 	}
-	// deplasarea elementelor vectorului pentru a face loc pentru noua eticheta
-	for (int j = array_size - 1; j > i; j--)
-		tag_array[j] = tag_array[j - 1];
-	tag_array[i] = tag;
+	return lo;
 }
 
-/* functie care elimina o eticheta din vectorul de etichete
+/* functie care calculeaza pozitia pe hash ring a replicii r a unui server
+ * pentru id-urile mai mici decat REPLICA_LABEL_STEP, pozitia este hashul
+ * etichetei r * REPLICA_LABEL_STEP + id; pentru celelalte, replica este
+ * amestecata cu hashul id-ului, ca etichetele a doua servere sa nu coincida
 */
-void remove_tag(int *tag_array, int tag, int array_size) {
-	// se calculeaza hashul etichetei de eliminat
-	unsigned int tag_hash = hash_uint(&tag);
-	// se cauta pozitia etichetei in vectorul de etichete
-	int i = 0;
-	for (i = 0; i < array_size; i++)
-		if (hash_uint(&tag_array[i]) == tag_hash)
-			break;
-
-	// se sterge elementul de pe pozitia i
-	for (int j = i; j < array_size - 1; j++)
-		tag_array[j] = tag_array[j + 1];
+static unsigned int label_hash(int server_id, int r) {
+	if (server_id < REPLICA_LABEL_STEP) {
+		int label = r * REPLICA_LABEL_STEP + server_id;
+		return hash_uint(&label);
+	}
+	unsigned int label = hash_uint(&server_id) + r * 0x9e3779b9u;
+	return hash_uint(&label);
 }
 
-/* functie care gaseste serverul "vecin" al altui server, pe hash ring
-* serverele sunt reprezentate prin etichete, in vectorul de etichete
+/* functie care adauga, in ordine, o eticheta in vectorul de etichete
+ * hashul etichetei este calculat o singura data si pastrat langa slotul
+ * serverului ei
+ * array_size include si pozitia noua, aflata la finalul vectorului
 */
-int find_neighbour_server(int *tag_array, int tag, int array_size) {
-	// se calculeaza hashul etichetei
-	unsigned int tag_hash = hash_uint(&tag);
-	// se cauta urmatoarea eticheta cu hashul mai mare decat cel al etichetei
-	// date ca parametru
-	for (int i = 0; i < array_size; i++)
-		if (hash_uint(&tag_array[i]) > tag_hash)
-			return tag_array[i];
+void add_tag_in_order(ring_point *ring, unsigned int tag_hash, int slot,
+					  int array_size) {
+	// se obtine pozitia pe care trebuie sa fie inserata eticheta, dupa
+	// ultima eticheta cu hashul mai mic sau egal
+	int i = ring_upper_bound(ring, array_size - 1, tag_hash);
 
-	// daca hashul serv dat este mai mare decat hashurile tuturor etichetelor,
-	// vecinul lui va fi primul server
-	return tag_array[0];
+	// deplasarea elementelor vectorului pentru a face loc pentru noua eticheta
+	memmove(&ring[i + 1], &ring[i], (array_size - 1 - i) * sizeof(ring_point));
+	ring[i].hash = tag_hash;
+	ring[i].slot = slot;
 }
 
-/* functie care verifica daca un document trebuie mutat
-* de pe un server pe altul
+/* functie care elimina eticheta cu hashul dat a serverului din slotul slot
 */
-bool is_doc_moved(int server_id, int last_server, char *doc) {
-	// daca documentul trebuie mutat pe primul server, hashul lui va fi mai
-	// mare decat hashul ultimului server in vectorul de etichete
-	if (hash_uint(&last_server) < hash_string(doc) &&
-		hash_string(doc) > hash_uint(&server_id))
-		return true;
-	// documentul va fi mutat daca hashul serverului pe care se va muta este
-	// mai mare decat hashul documentului
-	return hash_uint(&server_id) > hash_string(doc);
+void remove_tag(ring_point *ring, unsigned int tag_hash, int slot,
+				int array_size) {
+	// eticheta este unul dintre ultimele puncte cu hashul mai mic sau egal
+	// cu al ei; etichetele altor servere pot avea acelasi hash
+	int i = ring_upper_bound(ring, array_size, tag_hash) - 1;
+	while (i >= 0 && ring[i].hash == tag_hash && ring[i].slot != slot)
+		i--;
+	if (i < 0 || ring[i].hash != tag_hash)
+		return;
+
+	// se sterge elementul de pe pozitia i
+	memmove(&ring[i], &ring[i + 1], (array_size - 1 - i) * sizeof(ring_point));
 }
 
 /* functie care executa taskurile ramase in coada de requesturi a unui server
 */
 void handle_remaining_requests(server *s) {
 	// se da serverului un request gol, care sa initieze executia taskurilor
-	request *foo = malloc(sizeof(request));
-	DIE(foo == NULL, "Failed to allocate memory.\n");
+	// numele gol nu schimba in mod eronat ordinea din cache; tipul "GET"
+	// pune in executie seria de dequeue-uri si procesari ale requesturilor
+	request foo = {
+		.type = GET_DOCUMENT,
+		.doc_name = "",
+		.doc_content = NULL,
+	};
 
-	foo->doc_content = malloc(DOC_CONTENT_LENGTH * sizeof(char));
-	DIE(foo->doc_content == NULL, "Failed to allocate memory.\n");
+	// se apeleaza functia de procesare a requesturilor
+	response *resp = server_handle_request(s, &foo);
+	// raspunsurile EDIT-urilor executate se scriu, iar response-ul
+	// requestului gol, ultimul din lista, nu ne intereseaza, asa ca este
+	// dat inapoi sink-ului fara a fi scris
+	response **last = &resp;
+	while ((*last)->next)
+		last = &(*last)->next;
+	response *discarded = *last;
+	*last = NULL;
+	if (resp)
+		sink_write_response(s->sink, resp);
+	sink_recycle_response(s->sink, discarded);
+}
 
-	foo->doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-	DIE(foo->doc_name == NULL, "Failed to allocate memory.\n");
+/* functie care executa taskurile ramase ale unui server; cu workeri,
+ * raspunsurile ajung in sink-ul workerului, de unde sunt mutate imediat in
+ * outputul principal, ca sa apara in aceeasi ordine ca in modul serial
+*/
+static void drain_server(load_balancer *main, server *s) {
+	unsigned int docs = s->nr_docs;
+	handle_remaining_requests(s);
+	main->stored_docs += s->nr_docs - docs;
+	if (s->sink != main->sink) {
+		sink_write_bytes(main->sink, s->sink->buff, s->sink->size);
+		s->sink->size = 0;
+	}
+}
 
-	// se initializeaza campurile requestului, pentru a nu
-	// schimba in mod eronat ordinea din cache
-	memset(foo->doc_name, 0, DOC_NAME_LENGTH);
-	memset(foo->doc_content, 0, DOC_CONTENT_LENGTH);
+/* functie care returneaza eticheta care detine pe hash ring pozitia data,
+ * adica prima eticheta cu hashul mai mare decat aceasta; pentru pozitia
+ * unei etichete, aceasta este eticheta "vecina" ei
+*/
+static ring_point *find_label_by_hash(ring_point *ring, int array_size,
+									  unsigned int hash) {
+	int i = ring_upper_bound(ring, array_size, hash);
+	// daca hashul este mai mare decat hashurile tuturor etichetelor,
+	// proprietarul este primul server
+	if (i == array_size)
+		return &ring[0];
+	return &ring[i];
+}
 
-	// se seteaza tipul requestului la "GET", pentru a pune in executie
-	// seria de dequeue-uri si procesari ale requesturilor
-	foo->type = 1;
+/* functia gaseste slotul serverului spre care sa fie redirectionat un
+ * request
+*/
+int find_server_to_forward(ring_point *ring, int array_size, char *doc) {
+	// serverul spre care va fi redirectionat requestul va fi primul server
+	// cu hashul mai mare decat hashul documentului
+	return find_label_by_hash(ring, array_size, hash_string(doc))->slot;
+}
 
-	// se apeleaza functia de procesare a requesturilor
-	response *resp = server_handle_request(s, foo);
-	// se elibereaza memoria alocata pentru request si response, deoarece
-	// rezultatul nu ne intereseaza, doar executia requesturilor
-	free(foo->doc_name);
-	free(foo->doc_content);
-	free(foo);
+/* functie care verifica daca un document trebuie mutat pe un server nou
+* documentul este mutat daca una dintre etichetele noului server a devenit
+* proprietara lui pe hash ring, adica prima eticheta cu hashul mai mare decat
+* hashul documentului, pastrat in doc_t
+*/
+bool is_doc_moved(ring_point *ring, int array_size, int slot,
+				  unsigned int doc_hash) {
+	return find_label_by_hash(ring, array_size, doc_hash)->slot == slot;
+}
 
-	free(resp->server_log);
-	if (resp->server_response)
-		free(resp->server_response);
-	free(resp);
+/* functie care returneaza serverul caruia ii apartine o eticheta
+*/
+static server *label_to_server(load_balancer *main, ring_point *label) {
+	return main->servers[label->slot];
 }
 
-/* functia gaseste un server spre care sa fie redirectionat un request
+/* functie care muta un document din database-ul unui server in database-ul
+ * altui server, eliminandu-l din cache-ul serverului sursa; nodul si
+ * documentul sunt doar mutate dintr-o lista in alta, fara copieri
 */
-int find_server_to_forward(int *tag_array, int array_size, char *doc) {
-	// se calculeaza hashul documentului
-	unsigned int doc_hash = hash_string(doc);
-	// serverul spre care va fi redirectionat requestul va fi primul server
-	// cu hashul mai mare decat hashul documentului
-	for (int i = 0; i < array_size; i++)
-		if (hash_uint(&tag_array[i]) > doc_hash)
-			return tag_array[i];
-	// daca hashul doc. este mai mare decat hashurile tuturor etichetelor,
-	// serverul spre care va fi redirectionat requestul va fi primul server
-	return tag_array[0];
+static void move_document(server *src, server *dst, dll_node_t *node) {
+	lru_cache_remove(src->cache, ((doc_t *)node->data)->doc_name);
+	server_unlink_document(src, node);
+	server_link_document(dst, node);
+}
+
+/* functie care pune la migrat arcul arc al serverului src, din care
+ * pozitiile [lo, hi) au acum alt proprietar
+*/
+static void add_migration(load_balancer *main, server *src, db_arc *arc,
+						  unsigned int lo, unsigned int hi) {
+	main->migrations = realloc(main->migrations, (main->nr_migrations + 1) *
+							   sizeof(migration));
+	DIE(main->migrations == NULL, "Failed to allocate memory.\n");
+
+	migration *m = &main->migrations[main->nr_migrations++];
+	m->src = src;
+	m->arc = arc;
+	m->lo = lo;
+	m->hi = hi;
+	m->cursor = NULL;
+	m->started = false;
+	main->migration_stats.arcs++;
+}
+
+/* functie care elibereaza serverul eliminat, dupa ce toate documentele lui
+ * au fost mutate
+*/
+static void free_retiring_server(load_balancer *main) {
+	if (main->retiring == NULL)
+		return;
+	main->coalesced_edits += main->retiring->coalesced_edits;
+	free_server(&main->retiring);
+	main->retiring = NULL;
+}
+
+/* functie care verifica daca un hash se afla intre pozitiile [lo, hi) ale
+ * ring-ului, intervalul putand trece prin 0
+*/
+static bool in_ring_range(unsigned int lo, unsigned int hi, unsigned int hash) {
+	if (lo < hi)
+		return lo <= hash && hash < hi;
+	return hash >= lo || hash < hi;
+}
+
+/* functie care returneaza hashul etichetei aflate inaintea etichetei de pe
+ * pozitia idx a ring-ului, sarind peste etichetele serverului din slotul
+ * slot (-1 pentru a nu sari peste nicio eticheta)
+*/
+static unsigned int prev_label_hash(load_balancer *main, int idx, int slot) {
+	int j = idx;
+	do {
+		j = (j - 1 + main->nr_tags) % main->nr_tags;
+	} while (main->s_tags[j].slot == slot && j != idx);
+	return main->s_tags[j].hash;
+}
+
+/* functie care muta un document de pe vechiul proprietar pe noul
+ * proprietar, la primul acces; coada sursei este golita intai, ca un EDIT
+ * aflat in ea pentru document sa fie executat inainte de mutare
+*/
+static void pull_document(load_balancer *main, server *src, server *dst,
+						  char *doc_name) {
+	if (!q_is_empty(src->task_queue))
+		drain_server(main, src);
+	dll_node_t *node = server_find_document(src, doc_name);
+	if (node == NULL)
+		return;
+
+	// cursorul unui arc in migrare nu trebuie sa ramana pe nodul mutat
+	for (int i = 0; i < main->nr_migrations; i++)
+		if (main->migrations[i].cursor == node)
+			main->migrations[i].cursor = node->next;
+	move_document(src, dst, node);
+	main->migration_stats.pulled++;
+}
+
+/* functie care verifica daca pe un server mai poate fi creat un document
+ * nou, fara ca acesta sa depaseasca load_factor ori media documentelor
+ * per server, socotind si documentul nou
+*/
+static bool has_capacity(load_balancer *main, server *s) {
+	double bound = ceil(main->load_factor * (main->stored_docs + 1) /
+						main->nr_servers);
+	return s->nr_docs < bound;
+}
+
+/* functie care returneaza slotul serverului pe care este creat un document
+ * nou, cu incarcarea limitata: proprietarul lui, eticheta label, daca are
+ * loc, altfel primul server cu loc dintre urmatoarele etichete de pe ring;
+ * un astfel de server exista mereu, deoarece media este sub limita
+*/
+static int bounded_slot(load_balancer *main, ring_point *label) {
+	int idx = label - main->s_tags;
+	for (int i = 0; i < main->nr_tags; i++) {
+		ring_point *next = &main->s_tags[(idx + i) % main->nr_tags];
+		if (has_capacity(main, label_to_server(main, next)))
+			return next->slot;
+	}
+	return label->slot;
+}
+
+/* functie care retine serverul pe care a fost creat un document plasat in
+ * afara proprietarului lui
+*/
+static void add_spilled_doc(load_balancer *main, char *doc_name, int slot) {
+	ht_put(main->spilled, doc_name, strlen(doc_name) + 1, &slot, sizeof(int));
+	main->spilled_docs++;
+}
+
+/* functie care returneaza serverul unui document cu incarcarea limitata:
+ * serverul pe care a fost plasat documentul, daca acesta nu este
+ * proprietarul lui, altfel proprietarul; doar un EDIT pentru un document
+ * nou poate fi plasat pe alt server
+*/
+static server *route_bounded(load_balancer *main, request *req,
+							 ring_point *label) {
+	int *slot = ht_get(main->spilled, req->doc_name);
+	if (slot)
+		return main->servers[*slot];
+
+	server *owner = label_to_server(main, label);
+	if (req->type != EDIT_DOCUMENT || has_capacity(main, owner) ||
+		server_find_document(owner, req->doc_name))
+		return owner;
+	// documentul poate fi creat de un EDIT din coada proprietarului, pus
+	// cand acesta mai avea loc; coada este executata inainte de decizie
+	if (!q_is_empty(owner->task_queue)) {
+		drain_server(main, owner);
+		if (server_find_document(owner, req->doc_name))
+			return owner;
+	}
+
+	int dst = bounded_slot(main, label);
+	if (dst != label->slot)
+		add_spilled_doc(main, req->doc_name, dst);
+	return main->servers[dst];
+}
+
+/* functie care returneaza serverul spre care trebuie trimis un request
+ * pentru un document: proprietarul lui de pe hash ring sau, daca arcul pe
+ * care se afla documentul este inca in migrare si documentul nu a ajuns la
+ * noul proprietar, vechiul proprietar; cu migrarea la primul acces,
+ * documentul este adus intai pe noul proprietar
+*/
+static server *route_document(load_balancer *main, request *req) {
+	char *doc_name = req->doc_name;
+	unsigned int hash = hash_string(doc_name);
+	if (main->placement)
+		return main->servers[placement_locate(main->placement, hash)];
+	ring_point *label = find_label_by_hash(main->s_tags, main->nr_tags, hash);
+	if (main->load_factor > 0)
+		return route_bounded(main, req, label);
+	server *owner = label_to_server(main, label);
+
+	for (int i = 0; i < main->nr_migrations; i++) {
+		migration *m = &main->migrations[i];
+		if (m->src == owner || !in_ring_range(m->lo, m->hi, hash))
+			continue;
+		if (server_find_document(owner, doc_name))
+			break;
+		// vechiul proprietar nu mai primeste requesturi pentru arc, deci
+		// un document nou este creat direct pe noul proprietar
+		if (main->lazy_migration) {
+			pull_document(main, m->src, owner, doc_name);
+			break;
+		}
+		main->migration_stats.forwarded++;
+		return m->src;
+	}
+	return owner;
+}
+
+void loader_migrate_step(load_balancer *main) {
+	if (main->nr_migrations == 0)
+		return;
+
+	migration *m = &main->migrations[0];
+	// EDIT-urile din coada sursei se executa inainte ca documentele sa fie
+	// mutate, ca sa nu ramana requesturi pentru documente plecate
+	if (!q_is_empty(m->src->task_queue))
+		drain_server(main, m->src);
+	if (!m->started) {
+		m->cursor = m->arc->docs->head;
+		m->started = true;
+	}
+
+	// un pas verifica cel mult migrate_batch documente, deci dureaza
+	// acelasi timp indiferent de dimensiunea arcului
+	for (unsigned int i = 0; i < main->migrate_batch && m->cursor; i++) {
+		dll_node_t *node = m->cursor;
+		m->cursor = node->next;
+		ring_point *label = find_label_by_hash(main->s_tags, main->nr_tags,
+											   ((doc_t *)node->data)->hash);
+		server *dst = label_to_server(main, label);
+		if (dst == m->src)
+			continue;
+		move_document(m->src, dst, node);
+		main->migration_stats.docs_moved++;
+	}
+	main->migration_stats.steps++;
+
+	// arcul este terminat; documentele create intre pasi au fost adaugate
+	// la finalul lui, deci au fost si ele verificate
+	if (m->cursor == NULL) {
+		main->nr_migrations--;
+		memmove(m, m + 1, main->nr_migrations * sizeof(migration));
+		if (main->nr_migrations == 0)
+			free_retiring_server(main);
+	}
+}
+
+void loader_set_lazy_migration(load_balancer *main) {
+	main->lazy_migration = true;
+	if (main->migrate_batch == 0)
+		main->migrate_batch = LAZY_SWEEP_BATCH;
+}
+
+void loader_finish_migrations(load_balancer *main) {
+	main->migration_stats.forced += main->nr_migrations;
+	while (main->nr_migrations)
+		loader_migrate_step(main);
 }
 
 /* functie care creeaza un load balancer
@@ -142,91 +394,530 @@ load_balancer *init_load_balancer(bool enable_vnodes) {
 	main->hash_function_servers = hash_uint;
 	main->hash_function_docs = hash_string;
 	main->enable_vnodes = enable_vnodes;
-	// se aloca memorie pentru vectorul care face legatura intre eticheta si
-	// indexul serverului
-	main->tag_to_index = calloc(MAX_SERVERS, sizeof(int));
-	main->servers = NULL;
-	main->s_tags = NULL;
+	main->nr_replicas = enable_vnodes ? VNODES_REPLICAS : 1;
+	main->coalesce_edits = false;
+	main->coalesced_edits = 0;
+	main->sink = NULL;
+	main->workers = NULL;
+	main->batch = NULL;
+	main->batch_cap = 0;
+	main->migrate_batch = 0;
+	main->lazy_migration = false;
+	main->migrations = NULL;
+	main->nr_migrations = 0;
+	main->retiring = NULL;
+	memset(&main->migration_stats, 0, sizeof(migration_stats));
+	// vectorii de servere si de etichete pornesc de la INITIAL_SLOTS
+	// elemente si isi dubleaza capacitatea cand se umplu
+	main->slots_cap = INITIAL_SLOTS;
+	main->servers = malloc(main->slots_cap * sizeof(server *));
+	DIE(main->servers == NULL, "Failed to allocate memory.\n");
+	main->free_slots = malloc(main->slots_cap * sizeof(int));
+	DIE(main->free_slots == NULL, "Failed to allocate memory.\n");
+	main->nr_slots = 0;
+	main->nr_free = 0;
 	main->nr_servers = 0;
+	main->tags_cap = INITIAL_SLOTS;
+	main->s_tags = malloc(main->tags_cap * sizeof(ring_point));
+	DIE(main->s_tags == NULL, "Failed to allocate memory.\n");
+	main->nr_tags = 0;
+	main->placement = NULL;
+	main->rebalanced_docs = 0;
+	main->server_changes = 0;
+	main->load_factor = 0;
+	main->spilled = NULL;
+	main->stored_docs = 0;
+	main->spilled_docs = 0;
+	main->hot_keys = NULL;
+	main->hot_replicas = 0;
+	memset(&main->replica_stats, 0, sizeof(replica_stats));
+	main->nr_copies = 1;
+	main->write_quorum = 1;
+	main->read_quorum = 1;
+	main->dropped_copies = 0;
+	main->cache_config.policy = CACHE_LRU;
+	main->cache_config.in_bytes = false;
+	main->cache_config.budget = NULL;
 	return main;
 }
 
+void loader_set_replication(load_balancer *main, int nr_copies,
+							int write_quorum, int read_quorum) {
+	main->nr_copies = nr_copies;
+	main->write_quorum = write_quorum;
+	main->read_quorum = read_quorum;
+}
+
+/* functie care verifica daca un slot se afla printre primele n sloturi
+ * dintr-un vector
+*/
+static bool has_slot(int *slots, int n, int slot) {
+	for (int i = 0; i < n; i++)
+		if (slots[i] == slot)
+			return true;
+	return false;
+}
+
+/* functie care gaseste sloturile serverelor care tin copiile unui
+ * document: primele nr_copies servere distincte de pe ring, incepand cu
+ * proprietarul lui; returneaza numarul lor, mai mic daca nu exista destule
+ * servere
+*/
+static int copy_slots(load_balancer *main, unsigned int hash, int *slots) {
+	if (main->nr_tags == 0)
+		return 0;
+	int idx = find_label_by_hash(main->s_tags, main->nr_tags, hash) -
+			  main->s_tags;
+	int n = 0;
+	for (int i = 0; i < main->nr_tags && n < main->nr_copies; i++) {
+		int slot = main->s_tags[(idx + i) % main->nr_tags].slot;
+		if (!has_slot(slots, n, slot))
+			slots[n++] = slot;
+	}
+	return n;
+}
+
+/* functie care copiaza pe un server nou documentele ale caror copii il
+ * includ acum si le sterge de pe serverele care nu le mai tin; acestea
+ * sunt printre primele nr_copies servere de dupa fiecare eticheta noua,
+ * care isi executa intai coada, ca sa aiba ultimul continut
+*/
+static void replicate_on_add(load_balancer *main, int slot) {
+	server *added = main->servers[slot];
+	for (int r = 0; r < main->nr_replicas; r++) {
+		int idx = ring_upper_bound(main->s_tags, main->nr_tags,
+								   label_hash(added->id, r)) - 1;
+		int holders[MAX_COPIES];
+		int nr_holders = 0;
+		for (int i = 1; i < main->nr_tags && nr_holders < main->nr_copies;
+			 i++) {
+			int next = main->s_tags[(idx + i) % main->nr_tags].slot;
+			if (next != slot && !has_slot(holders, nr_holders, next))
+				holders[nr_holders++] = next;
+		}
+
+		for (int h = 0; h < nr_holders; h++) {
+			server *holder = main->servers[holders[h]];
+			drain_server(main, holder);
+			for (int j = 0; j < holder->nr_arcs; j++) {
+				dll_node_t *node = holder->arcs[j].docs->head;
+				while (node != NULL) {
+					dll_node_t *next = node->next;
+					doc_t *doc = node->data;
+					int copies[MAX_COPIES];
+					int n = copy_slots(main, doc->hash, copies);
+					if (has_slot(copies, n, slot) &&
+						!server_find_document(added, doc->doc_name)) {
+						server_copy_document(added, doc);
+						main->rebalanced_docs++;
+					}
+					if (!has_slot(copies, n, holders[h])) {
+						server_drop_document(holder, node);
+						main->dropped_copies++;
+					}
+					node = next;
+				}
+			}
+		}
+	}
+}
+
+/* functie care copiaza documentele unui server eliminat, a carui coada a
+ * fost executata, pe serverele care ii iau locul printre copiile lor;
+ * celelalte copii au deja documentele, iar un server caruia ii lipseste
+ * documentul isi executa intai coada, care poate inca sa il creeze
+*/
+static void replicate_on_remove(load_balancer *main, server *removed) {
+	for (int i = 0; i < removed->nr_arcs; i++) {
+		for (dll_node_t *node = removed->arcs[i].docs->head; node;
+			 node = node->next) {
+			doc_t *doc = node->data;
+			int copies[MAX_COPIES];
+			int n = copy_slots(main, doc->hash, copies);
+			for (int j = 0; j < n; j++) {
+				server *s = main->servers[copies[j]];
+				if (server_find_document(s, doc->doc_name))
+					continue;
+				drain_server(main, s);
+				if (server_find_document(s, doc->doc_name))
+					continue;
+				server_copy_document(s, doc);
+				main->rebalanced_docs++;
+			}
+		}
+	}
+}
+
+/* functie care alege copia care serveste un GET: cea cu cele mai putine
+ * requesturi dintre primele read_quorum copii
+*/
+static server *read_copy(load_balancer *main, int *slots, int n) {
+	server *best = main->servers[slots[0]];
+	for (int i = 1; i < n && i < main->read_quorum; i++)
+		if (main->servers[slots[i]]->nr_requests < best->nr_requests)
+			best = main->servers[slots[i]];
+	return best;
+}
+
+/* functie care trimite un request copiilor unui document: un GET uneia
+ * dintre ele, iar un EDIT tuturor; doar prima copie pune EDIT-ul in coada
+ * si il raporteaza, celelalte il aplica imediat, fara raspuns
+*/
+static response *forward_to_copies(load_balancer *main, request *req) {
+	int slots[MAX_COPIES];
+	int n = copy_slots(main, hash_string(req->doc_name), slots);
+	server *primary = main->servers[slots[0]];
+	if (req->type == GET_DOCUMENT) {
+		server *s = read_copy(main, slots, n);
+		s->nr_requests++;
+		if (s == primary)
+			return server_handle_request(s, req);
+
+		// EDIT-urile din coada primei copii sunt raportate inaintea GET-ului
+		response *first = server_run_queue(primary);
+		response **last = &first;
+		while (*last)
+			last = &(*last)->next;
+		*last = server_handle_request(s, req);
+		return first;
+	}
+
+	for (int i = 1; i < n; i++) {
+		server *s = main->servers[slots[i]];
+		s->nr_requests++;
+		server_apply_edit(s, req->doc_name, req->doc_content);
+	}
+	primary->nr_requests++;
+	return server_handle_request(primary, req);
+}
+
+/* functie care trimite un request copiilor unui document, prin workeri, ca
+ * forward_to_copies(); un EDIT este confirmat dupa ce write_quorum copii
+ * l-au primit
+*/
+static request_future *forward_async_to_copies(load_balancer *main,
+											   request *req, bool owned) {
+	int slots[MAX_COPIES];
+	int n = copy_slots(main, hash_string(req->doc_name), slots);
+	server *primary = main->servers[slots[0]];
+	if (req->type == GET_DOCUMENT) {
+		server *s = read_copy(main, slots, n);
+		s->nr_requests++;
+		if (s != primary) {
+			request drain = { GET_DOCUMENT, NULL, NULL };
+			worker_pool_submit(main->workers, primary, &drain, false,
+							   FUTURE_DRAIN);
+		}
+		return worker_pool_submit(main->workers, s, req, owned,
+								  FUTURE_REQUEST);
+	}
+
+	// requesturile sunt retrase in ordinea trimiterii, deci ultima copie
+	// elibereaza numele si continutul
+	request_future *futures[MAX_COPIES];
+	for (int i = 0; i < n; i++) {
+		server *s = main->servers[slots[i]];
+		s->nr_requests++;
+		futures[i] = worker_pool_submit(main->workers, s, req,
+										owned && i == n - 1,
+										i == 0 ? FUTURE_REQUEST : FUTURE_COPY);
+	}
+	worker_pool_wait_quorum(futures, n, main->write_quorum < n ?
+							main->write_quorum : n);
+	return futures[0];
+}
+
+void loader_set_hot_replicas(load_balancer *main, int nr_replicas) {
+	main->hot_keys = init_hot_keys();
+	main->hot_replicas = nr_replicas;
+}
+
+/* functie care sterge de pe servere replicile unui document fierbinte
+*/
+static void drop_replicas(load_balancer *main, hot_doc *hot) {
+	for (int i = 0; i < hot->nr_replicas; i++)
+		server_drop_replica(main->servers[hot->replicas[i]], hot->doc_name);
+	if (hot->nr_replicas)
+		main->replica_stats.invalidations++;
+	hot->nr_replicas = 0;
+	hot->next = 0;
+}
+
+/* functie care scrie in replicile unui document fierbinte continutul
+ * unui EDIT; un GET returneaza continutul ultimului EDIT primit pentru
+ * document, deci replicile raspund la fel ca proprietarul dupa ce acesta
+ * isi executa coada
+*/
+static void update_replicas(load_balancer *main, hot_doc *hot,
+							char *doc_content) {
+	if (doc_content == NULL) {
+		drop_replicas(main, hot);
+		return;
+	}
+	for (int i = 0; i < hot->nr_replicas; i++)
+		server_put_replica(main->servers[hot->replicas[i]], hot->doc_name,
+						   doc_content);
+	if (hot->nr_replicas)
+		main->replica_stats.updates++;
+}
+
+/* functie care sterge replicile tuturor documentelor fierbinti, inaintea
+ * unei schimbari de servere, cand sloturile replicilor nu mai sunt
+ * succesorii proprietarului
+*/
+static void drop_all_replicas(load_balancer *main) {
+	if (main->hot_keys == NULL)
+		return;
+	for (int i = 0; i < main->hot_keys->nr_docs; i++)
+		drop_replicas(main, &main->hot_keys->docs[i]);
+}
+
+/* functie care numara un request pentru un document si returneaza intrarea
+ * lui fierbinte; un document care atinge HOT_KEY_THRESHOLD accesari
+ * devine fierbinte, inlocuind, daca nu mai este loc, documentul fierbinte
+ * cu cele mai putine accesari, daca acesta are mai putine decat el
+*/
+static hot_doc *track_hot_doc(load_balancer *main, char *doc_name) {
+	unsigned int count = hot_keys_count(main->hot_keys, doc_name);
+	hot_doc *hot = hot_keys_find(main->hot_keys, doc_name);
+	if (hot) {
+		hot->count = count;
+		return hot;
+	}
+	if (count < HOT_KEY_THRESHOLD)
+		return NULL;
+
+	hot_doc *coldest = hot_keys_coldest(main->hot_keys);
+	if (coldest) {
+		if (coldest->count >= count)
+			return NULL;
+		drop_replicas(main, coldest);
+		hot_keys_evict(main->hot_keys, coldest);
+	}
+	return hot_keys_admit(main->hot_keys, doc_name, count);
+}
+
+/* functie care copiaza un document fierbinte de pe serverul care tocmai a
+ * raspuns la un GET pentru el pe urmatoarele hot_replicas servere de pe
+ * ring; coada serverului a fost executata de GET, deci continutul este cel
+ * de dupa toate EDIT-urile primite
+*/
+static void replicate_hot_doc(load_balancer *main, hot_doc *hot,
+							  server *owner) {
+	dll_node_t *node = server_find_document(owner, hot->doc_name);
+	if (node == NULL)
+		return;
+	doc_t *doc = node->data;
+
+	int idx = find_label_by_hash(main->s_tags, main->nr_tags, doc->hash) -
+			  main->s_tags;
+	for (int i = 0; i < main->nr_tags && hot->nr_replicas < main->hot_replicas;
+		 i++) {
+		int slot = main->s_tags[(idx + i) % main->nr_tags].slot;
+		// cu vnodes, un server poate aparea de mai multe ori printre
+		// succesori, dar primeste o singura replica
+		bool taken = main->servers[slot] == owner;
+		for (int j = 0; j < hot->nr_replicas && !taken; j++)
+			taken = hot->replicas[j] == slot;
+		if (taken)
+			continue;
+		server_put_replica(main->servers[slot], doc->doc_name,
+						   doc->doc_content);
+		hot->replicas[hot->nr_replicas++] = slot;
+	}
+	if (hot->nr_replicas)
+		main->replica_stats.refreshes++;
+}
+
+void loader_set_bounded_load(load_balancer *main, double load_factor) {
+	main->load_factor = load_factor;
+	main->spilled = ht_create(SPILLED_INIT_SIZE, hash_string,
+							  compare_function, key_val_free_function);
+}
+
+void loader_set_cache_policy(load_balancer *main, cache_policy policy) {
+	main->cache_config.policy = policy;
+}
+
+void loader_set_cache_bytes(load_balancer *main) {
+	main->cache_config.in_bytes = true;
+}
+
+void loader_set_cache_budget(load_balancer *main, size_t limit) {
+	main->cache_config.budget = init_cache_budget(limit);
+}
+
+void loader_set_placement(load_balancer *main, placement_type type) {
+	if (type != PLACEMENT_RING)
+		main->placement = init_placement(type);
+}
+
+/* functie care muta, dupa o schimbare de servere, documentele serverelor
+ * care pot pierde documente conform strategiei de plasare; fiecare server
+ * isi executa intai coada
+*/
+static void rebalance_servers(load_balancer *main) {
+	placement *p = main->placement;
+	for (int i = 0; i < p->nr_changed; i++) {
+		int slot = p->changed[i];
+		server *src = main->servers[slot];
+		drain_server(main, src);
+		for (int j = 0; j < src->nr_arcs; j++) {
+			dll_node_t *node = src->arcs[j].docs->head;
+			while (node != NULL) {
+				dll_node_t *next = node->next;
+				int dst = placement_relocate(p, ((doc_t *)node->data)->hash,
+											 slot);
+				// fara servere, documentele raman pe serverul eliminat
+				if (dst >= 0 && dst != slot) {
+					move_document(src, main->servers[dst], node);
+					main->rebalanced_docs++;
+				}
+				node = next;
+			}
+		}
+	}
+}
+
+/* functie care returneaza un slot pentru un server nou: ultimul slot
+ * eliberat sau, daca nu exista, urmatorul slot nefolosit; vectorul de
+ * servere isi dubleaza capacitatea cand este plin
+*/
+static int alloc_server_slot(load_balancer *main) {
+	if (main->nr_free)
+		return main->free_slots[--main->nr_free];
+
+	if (main->nr_slots == main->slots_cap) {
+		main->slots_cap *= 2;
+		main->servers = realloc(main->servers,
+								main->slots_cap * sizeof(server *));
+		DIE(main->servers == NULL, "Failed to allocate memory.\n");
+		main->free_slots = realloc(main->free_slots,
+								   main->slots_cap * sizeof(int));
+		DIE(main->free_slots == NULL, "Failed to allocate memory.\n");
+	}
+	return main->nr_slots++;
+}
+
+/* functie care returneaza slotul serverului cu id-ul dat sau -1 daca
+ * serverul nu exista; prima eticheta a serverului se afla pe ring la
+ * pozitia label_hash(server_id, 0), deci slotul este gasit prin cautare
+ * binara, fara un index separat
+*/
+static int find_server_slot(load_balancer *main, int server_id) {
+	unsigned int hash = label_hash(server_id, 0);
+	int i = ring_upper_bound(main->s_tags, main->nr_tags, hash) - 1;
+	// etichetele altor servere pot avea acelasi hash
+	for (; i >= 0 && main->s_tags[i].hash == hash; i--)
+		if (main->servers[main->s_tags[i].slot]->id == server_id)
+			return main->s_tags[i].slot;
+	return -1;
+}
+
+/* functie care face loc pe hash ring pentru nr_tags etichete, dubland
+ * capacitatea vectorului de etichete
+*/
+static void reserve_tags(load_balancer *main, int nr_tags) {
+	if (nr_tags <= main->tags_cap)
+		return;
+	while (main->tags_cap < nr_tags)
+		main->tags_cap *= 2;
+	main->s_tags = realloc(main->s_tags, main->tags_cap * sizeof(ring_point));
+	DIE(main->s_tags == NULL, "Failed to allocate memory.\n");
+}
+
 /* functie care adauga un server in load balancer
 */
 void loader_add_server(load_balancer *main, int server_id, int cache_size) {
-	// se verifica daca numarul serverelor nu depaseste maximul posibil
-	if (main->nr_servers < MAX_SERVERS) {
-		// se adauga eticheta serverului in vectorul de etichete
-		main->tag_to_index[server_id] = main->nr_servers;
-		// se obtine indexul serverului in vectorul de servere
-		int curr_idx = main->tag_to_index[server_id];
-
-		// se aloca memorie pentru serverul ce urmeaza sa fie adaugat si se
-		// realoca vectorii de servere si etichete
-		main->nr_servers++;
-		main->servers =
-			realloc(main->servers, main->nr_servers * sizeof(server *));
-		main->servers[curr_idx] = init_server(cache_size);
-		main->servers[curr_idx]->id = server_id;
-		main->s_tags = realloc(main->s_tags, main->nr_servers * sizeof(int));
-
-		// se adauga eticheta in ordine in vectorul de etichete
-		add_tag_in_order(main->s_tags, server_id, main->nr_servers);
-		// se cauta vecinul noului server si indexul lui in vectorul de servere
-		int neighbour =
-			find_neighbour_server(main->s_tags, server_id, main->nr_servers);
-		int neighbour_idx = main->tag_to_index[neighbour];
+	// redistribuirea documentelor atinge mai multe servere, deci se
+	// asteapta intai toate requesturile trimise workerilor
+	if (main->workers)
+		worker_pool_wait_all(main->workers);
+	// o migrare inceputa se termina inainte de o noua schimbare
+	loader_finish_migrations(main);
+	drop_all_replicas(main);
 
-		// se executa toate taskurile din coada serverului vecin
-		handle_remaining_requests(main->servers[neighbour_idx]);
+	// un id folosit deja nu primeste un al doilea server
+	if (find_server_slot(main, server_id) >= 0)
+		return;
+
+	// serverul primeste un slot, pe care il pastreaza pana este eliminat
+	int slot = alloc_server_slot(main);
+	server *added = init_server(cache_size, &main->cache_config);
+	added->id = server_id;
+	added->coalesce_edits = main->coalesce_edits;
+	added->sink = main->workers ?
+		worker_pool_sink(main->workers, server_id) : main->sink;
+	main->servers[slot] = added;
+	main->nr_servers++;
+	main->server_changes++;
+	reserve_tags(main, main->nr_tags + main->nr_replicas);
+
+	// se adauga in ordine etichetele replicilor in vectorul de etichete,
+	// iar serverul primeste arcul de ring al fiecareia
+	for (int r = 0; r < main->nr_replicas; r++) {
+		unsigned int hash = label_hash(server_id, r);
+		main->nr_tags++;
+		add_tag_in_order(main->s_tags, hash, slot, main->nr_tags);
+		if (!main->placement)
+			server_add_arc(added, hash);
+	}
 
-		// se distribuie documentele vecinului serverului nou, iar cele care
-		// trebuie sa fie mutate sunt eliminate din cache si mutate
-		dll_node_t *aux = main->servers[neighbour_idx]->database->head;
+	// fara hash ring, serverul tine toate documentele intr-un singur arc,
+	// iar strategia de plasare spune ce servere ii pot ceda documente
+	if (main->placement) {
+		server_add_arc(added, 0);
+		placement_add_server(main->placement, slot, server_id);
+		rebalance_servers(main);
+		return;
+	}
+	// cu replicarea, serverul primeste copii ale documentelor
+	if (main->nr_copies > 1) {
+		replicate_on_add(main, slot);
+		return;
+	}
+
+	// fiecare eticheta noua imparte arcul etichetei urmatoare; daca
+	// aceasta apartine altui server, documentele de pe arcul ei care
+	// apartin acum noului server sunt mutate
+	for (int r = 0; r < main->nr_replicas; r++) {
+		unsigned int hash = label_hash(server_id, r);
+		ring_point *next_label = find_label_by_hash(main->s_tags,
+													main->nr_tags, hash);
+		if (next_label->slot == slot)
+			continue;
+
+		server *neighbour = label_to_server(main, next_label);
+		// se parcurge doar arcul impartit, nu tot database-ul vecinului;
+		// arcul etichetei urmatoare este primul arc al vecinului cu
+		// hashul cel putin egal cu al ei
+		db_arc *arc = server_find_arc(neighbour, next_label->hash - 1);
+		// cu migrarea treptata, arcul este doar pus la migrat; noul
+		// server preia pozitiile de dupa ultima eticheta a altui server
+		if (main->migrate_batch) {
+			int idx = ring_upper_bound(main->s_tags, main->nr_tags, hash) - 1;
+			add_migration(main, neighbour, arc,
+						  prev_label_hash(main, idx, slot), hash);
+			continue;
+		}
+
+		// se executa toate taskurile din coada serverului vecin
+		drain_server(main, neighbour);
+		dll_node_t *aux = arc->docs->head;
 		while (aux != NULL) {
-			// verificam daca documentul trebuie mutat pe noul server
 			dll_node_t *next = aux->next;
-			if (is_doc_moved(server_id, main->s_tags[main->nr_servers - 1],
-							 ((doc_t *)aux->data)->doc_name)) {
-				// eliminarea documentului din cache-ul vecinului
-				lru_cache_remove(main->servers[neighbour_idx]->cache,
-								 ((doc_t *)aux->data)->doc_name);
-
-				// se face o copie a documentului
-				doc_t *to_move = malloc(sizeof(doc_t));
-				DIE(to_move == NULL, "Failed to allocate memory.\n");
-
-				to_move->doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-				DIE(to_move->doc_name == NULL, "Failed to allocate memory.\n");
-
-				snprintf(to_move->doc_name, DOC_NAME_LENGTH, "%s",
-						 (char *)((doc_t *)aux->data)->doc_name);
-
-				if (((doc_t *)aux->data)->doc_content) {
-					to_move->doc_content =
-						malloc(DOC_CONTENT_LENGTH * sizeof(char));
-					DIE(to_move->doc_content == NULL,
-						"Failed to allocate memory\n");
-					snprintf(to_move->doc_content, DOC_CONTENT_LENGTH, "%s",
-						   (char *)((doc_t *)aux->data)->doc_content);
-				}
-
-				// se adauga in database-ul noului server si se sterge din
-				// database-ul vecinului
-				dll_add_nth_node(main->servers[curr_idx]->database,
-								 main->servers[curr_idx]->database->size,
-								 to_move);
-				dll_remove_node(main->servers[neighbour_idx]->database, aux);
-
-				// se elibereaza memoria pentru copie
-				free(((doc_t *)aux->data)->doc_name);
-				if (((doc_t *)aux->data)->doc_content)
-					free(((doc_t *)aux->data)->doc_content);
-				free(aux->data);
-				free(aux);
-				free(to_move);
+			// verificam daca documentul trebuie mutat pe noul server
+			if (is_doc_moved(main->s_tags, main->nr_tags, slot,
+							 ((doc_t *)aux->data)->hash)) {
+				// un document plasat in afara proprietarului ajunge pe noul
+				// lui proprietar
+				if (main->spilled)
+					ht_remove_entry(main->spilled,
+									((doc_t *)aux->data)->doc_name);
+				move_document(neighbour, added, aux);
+				main->rebalanced_docs++;
 			}
-			// se trece la urmatorul document din database-ul vecinului
+			// se trece la urmatorul document de pe arc
 			aux = next;
 		}
 	}
@@ -235,112 +926,309 @@ void loader_add_server(load_balancer *main, int server_id, int cache_size) {
 /* functie care elimina un server din load balancer
 */
 void loader_remove_server(load_balancer *main, int server_id) {
-	// se verifica daca numarul serverelor nu depaseste maximul posibil
-	if (main->nr_servers < MAX_SERVERS) {
-		// se obtine indexul serverului in vectorul de servere
-		int curr_idx = main->tag_to_index[server_id];
-		// se cauta vecinul serverului ce urmeaza sa fie eliminat si indexul
-		// lui in vectorul de servere
-		int neighbour =
-			find_neighbour_server(main->s_tags, server_id, main->nr_servers);
-		int neighbour_idx = main->tag_to_index[neighbour];
-
-		// se executa toate taskurile din coada serverului ce urmeaza sa fie
-		// eliminat
-		handle_remaining_requests(main->servers[curr_idx]);
-
-		// se distribuie documentele serverului de eliminat vecinului, iar cele
-		// care trebuie sa fie mutate sunt eliminate din cache si mutate
-		dll_node_t *aux = main->servers[curr_idx]->database->head;
-		while (aux != NULL) {
-			// eliminarea documentului din cache-ul serverului de eliminat
-			dll_node_t *next = aux->next;
-			lru_cache_remove(main->servers[curr_idx]->cache,
-							 ((doc_t *)aux->data)->doc_name);
-
-			// se face o copie a documentului
-			doc_t *to_move = malloc(sizeof(doc_t));
-			DIE(to_move == NULL, "Failed to allocate memory.\n");
-
-			to_move->doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-			DIE(to_move->doc_name == NULL, "Failed to allocate memory.\n");
-
-			snprintf(to_move->doc_name, DOC_NAME_LENGTH, "%s",
-					 (char *)((doc_t *)aux->data)->doc_name);
-
-			if (((doc_t *)aux->data)->doc_content) {
-				to_move->doc_content =
-					malloc(DOC_CONTENT_LENGTH * sizeof(char));
-				DIE(to_move->doc_content == NULL,
-					"Failed to allocate memory.\n");
-				snprintf(to_move->doc_content, DOC_CONTENT_LENGTH, "%s",
-						 (char *)((doc_t *)aux->data)->doc_content);
-			}
+	if (main->workers)
+		worker_pool_wait_all(main->workers);
+	loader_finish_migrations(main);
+	drop_all_replicas(main);
 
-			// se adauga in database-ul vecinului si se sterge din database-ul
-			// serverului de eliminat
-			dll_add_nth_node(main->servers[neighbour_idx]->database,
-							 main->servers[neighbour_idx]->database->size,
-							 to_move);
-			dll_remove_node(main->servers[curr_idx]->database, aux);
-
-			// se elibereaza memoria pentru copie
-			free(((doc_t *)aux->data)->doc_name);
-			if (((doc_t *)aux->data)->doc_content)
-				free(((doc_t *)aux->data)->doc_content);
-			free(aux->data);
-			free(aux);
-			free(to_move);
-			// se trece la urmatorul document din database-ul serverului de
-			// eliminat
-			aux = next;
-		}
+	// se obtine slotul serverului; un id necunoscut este ignorat
+	int slot = find_server_slot(main, server_id);
+	if (slot < 0)
+		return;
+	server *removed = main->servers[slot];
+	main->server_changes++;
+	// cu migrarea treptata, serverul este scos de pe ring, dar isi
+	// pastreaza documentele si coada pana cand arcele lui sunt migrate
+	bool retire = main->migrate_batch && main->nr_tags > main->nr_replicas;
+
+	// se executa toate taskurile din coada serverului ce urmeaza sa fie
+	// eliminat
+	if (!retire)
+		drain_server(main, removed);
+
+	// arcul fiecarei etichete a serverului, de la eticheta precedenta de
+	// pe ring, va fi migrat
+	for (int i = 0; i < removed->nr_arcs && retire; i++) {
+		unsigned int hi = removed->arcs[i].hash;
+		int idx = ring_upper_bound(main->s_tags, main->nr_tags, hi) - 1;
+		add_migration(main, removed, &removed->arcs[i],
+					  prev_label_hash(main, idx, -1), hi);
+	}
+
+	// se elimina etichetele replicilor serverului din vectorul de etichete
+	for (int r = 0; r < main->nr_replicas; r++) {
+		remove_tag(main->s_tags, label_hash(server_id, r), slot,
+				   main->nr_tags);
+		main->nr_tags--;
+	}
+	main->nr_servers--;
+	// fara servere ramase, documentele sunt eliberate odata cu serverul
+	if (main->nr_tags == 0)
+		main->stored_docs -= removed->nr_docs;
 
-		// se elimina eticheta serverului din vectorul de etichete
-		remove_tag(main->s_tags, server_id, main->nr_servers);
-		// se realoca memorie pentru vectorul de etichete
-		main->nr_servers--;
-		main->s_tags = realloc(main->s_tags, main->nr_servers * sizeof(int));
-
-		// se scade indexul elementelor de dupa serverul eliminat
-		for (int i = 0; i < main->nr_servers; i++)
-			if (main->tag_to_index[main->s_tags[i]] > curr_idx)
-				main->tag_to_index[main->s_tags[i]]--;
-
-		// se elimina serverul din vectorul de servere si se shifteaza
-		// elementele de dupa serverul eliminat
-		free_server(&main->servers[curr_idx]);
-		for (int i = curr_idx; i < main->nr_servers; i++) {
-			main->servers[i] = main->servers[i + 1];
+	// cu incarcarea limitata, fiecare document este plasat din nou, ca un
+	// document nou, pe proprietarul lui sau pe un succesor cu loc
+	for (int i = 0; i < removed->nr_arcs && main->nr_tags > 0 &&
+		 main->load_factor > 0; i++) {
+		dll_node_t *node = removed->arcs[i].docs->head;
+		while (node != NULL) {
+			dll_node_t *next = node->next;
+			doc_t *doc = node->data;
+			ht_remove_entry(main->spilled, doc->doc_name);
+			ring_point *label = find_label_by_hash(main->s_tags,
+												   main->nr_tags, doc->hash);
+			int dst = bounded_slot(main, label);
+			if (dst != label->slot)
+				add_spilled_doc(main, doc->doc_name, dst);
+			move_document(removed, main->servers[dst], node);
+			main->rebalanced_docs++;
+			node = next;
 		}
-		// se realoca memorie pentru vectorul de servere
-		main->servers =
-			realloc(main->servers, main->nr_servers * sizeof(server *));
-		// se seteaza indexul etichetei serverului eliminat pe 0
-		main->tag_to_index[server_id] = 0;
+	}
+
+	// cu replicarea, documentele sunt doar copiate pe serverele care iau
+	// locul serverului eliminat, iar copiile lui sunt eliberate cu el
+	if (main->nr_copies > 1 && main->nr_tags > 0)
+		replicate_on_remove(main, removed);
+
+	// documentele unui arc al serverului eliminat au acum acelasi
+	// proprietar, eticheta urmatoare de pe ring, deci arcul este mutat
+	// in intregime pe serverul acesteia
+	for (int i = 0; i < removed->nr_arcs && main->nr_tags > 0 &&
+		 !main->placement && main->nr_copies == 1; i++) {
+		db_arc *arc = &removed->arcs[i];
+		if (arc->docs->head == NULL || retire)
+			continue;
+		ring_point *label = find_label_by_hash(main->s_tags, main->nr_tags,
+								((doc_t *)arc->docs->head->data)->hash);
+		main->rebalanced_docs += arc->docs->size;
+		server_move_arc(removed, arc, label_to_server(main, label));
+	}
+	// altfel, strategia de plasare muta documentele serverului eliminat si
+	// pe cele ale serverelor afectate de eliminarea lui
+	if (main->placement) {
+		placement_remove_server(main->placement, slot);
+		rebalance_servers(main);
+	}
+
+	// slotul serverului devine liber, fara ca celelalte servere sa fie
+	// mutate
+	main->servers[slot] = NULL;
+	main->free_slots[main->nr_free++] = slot;
+	if (retire) {
+		main->retiring = removed;
+	} else {
+		main->coalesced_edits += removed->coalesced_edits;
+		free_server(&removed);
 	}
 }
 
 /* functie care redirectioneaza un request catre un server
 */
 response *loader_forward_request(load_balancer *main, request *req) {
-	int server_id =
-		find_server_to_forward(main->s_tags, main->nr_servers, req->doc_name);
-	// se redirectioneaza requestul catre serverul gasit
-	int server_idx = main->tag_to_index[server_id];
-	response *resp = server_handle_request(main->servers[server_idx], req);
+	if (main->nr_copies > 1)
+		return forward_to_copies(main, req);
+
+	// un GET pentru un document fierbinte cu replici este servit, pe rand,
+	// de proprietar si de fiecare replica; un EDIT actualizeaza replicile
+	hot_doc *hot = main->hot_keys ? track_hot_doc(main, req->doc_name) : NULL;
+	if (hot && req->type == GET_DOCUMENT && hot->nr_replicas) {
+		unsigned int pick = hot->next++ % (hot->nr_replicas + 1);
+		if (pick) {
+			server *replica = main->servers[hot->replicas[pick - 1]];
+			replica->nr_requests++;
+			main->replica_stats.reads++;
+			return server_read_replica(replica, req->doc_name);
+		}
+	} else if (hot && req->type == EDIT_DOCUMENT) {
+		update_replicas(main, hot, req->doc_content);
+	}
+
+	// se redirectioneaza requestul catre serverul caruia ii apartine eticheta
+	// documentului, sau catre vechiul proprietar, cat timp documentul este
+	// in migrare
+	server *s = route_document(main, req);
+	s->nr_requests++;
+	unsigned int docs = s->nr_docs;
+	response *resp = server_handle_request(s, req);
+	main->stored_docs += s->nr_docs - docs;
+
+	if (hot && req->type == GET_DOCUMENT && hot->nr_replicas == 0)
+		replicate_hot_doc(main, hot, s);
 	return resp;
 }
 
+/* functie care compara doua requesturi dintr-un batch dupa server si apoi
+ * dupa pozitie, astfel incat requesturile unui server raman in ordine
+*/
+static int compare_forward_slots(const void *a, const void *b) {
+	const forward_slot *x = a, *y = b;
+	if (x->s != y->s)
+		return (uintptr_t)x->s < (uintptr_t)y->s ? -1 : 1;
+	return x->pos - y->pos;
+}
+
+/* functie care redirectioneaza un batch de requesturi: le gaseste intai
+ * serverele, apoi le executa grupate pe servere; serverele nu au stare
+ * comuna, deci fiecare request primeste acelasi raspuns ca in ordinea
+ * initiala, iar raspunsurile sunt puse pe pozitiile requesturilor
+*/
+void loader_forward_batch(load_balancer *main, request *reqs, int nr_reqs,
+						  response **resps) {
+	if (nr_reqs > main->batch_cap) {
+		main->batch = realloc(main->batch, nr_reqs * sizeof(forward_slot));
+		DIE(main->batch == NULL, "Failed to allocate memory\n");
+		main->batch_cap = nr_reqs;
+	}
+
+	for (int i = 0; i < nr_reqs; i++) {
+		main->batch[i].s = route_document(main, &reqs[i]);
+		main->batch[i].s->nr_requests++;
+		main->batch[i].pos = i;
+	}
+	qsort(main->batch, nr_reqs, sizeof(forward_slot), compare_forward_slots);
+
+	for (int i = 0; i < nr_reqs; i++) {
+		forward_slot *slot = &main->batch[i];
+		unsigned int docs = slot->s->nr_docs;
+		resps[slot->pos] = server_handle_request(slot->s, &reqs[slot->pos]);
+		main->stored_docs += slot->s->nr_docs - docs;
+	}
+}
+
+/* functie care trimite un request workerului serverului caruia ii apartine
+ * si returneaza rezultatul viitor al acestuia
+*/
+request_future *loader_forward_async(load_balancer *main, request *req,
+									 bool owned) {
+	if (main->nr_copies > 1)
+		return forward_async_to_copies(main, req, owned);
+	server *s = route_document(main, req);
+	s->nr_requests++;
+	return worker_pool_submit(main->workers, s, req, owned, FUTURE_REQUEST);
+}
+
+/* functie care afiseaza distributia documentelor pe servere: numarul de
+ * documente al fiecarui server, media, deviatia standard si raportul
+ * dintre maxim si medie
+*/
+void loader_print_stats(load_balancer *main, FILE *out) {
+	double sum = 0, sum_sq = 0;
+	unsigned int max_docs = 0;
+	unsigned long nr_requests = 0, max_requests = 0;
+	unsigned long coalesced = main->coalesced_edits;
+	unsigned long hits = 0, misses = 0;
+	size_t cache_bytes = 0, max_cache_bytes = 0;
+	for (int i = 0; i < main->nr_slots; i++) {
+		if (main->servers[i] == NULL)
+			continue;
+		unsigned int docs = main->servers[i]->nr_docs;
+		server_memory mem;
+		server_memory_usage(main->servers[i], &mem);
+		unsigned long reqs = main->servers[i]->nr_requests;
+		fprintf(out, "[Stats] Server %d: %u documents, %lu requests, memory: "
+				"%zu B database, %zu B cache, %zu B queue (high-water %u "
+				"requests)\n", main->servers[i]->id, docs, reqs, mem.database,
+				mem.cache, mem.queue, main->servers[i]->task_queue->high_water);
+		nr_requests += reqs;
+		if (reqs > max_requests)
+			max_requests = reqs;
+		sum += docs;
+		sum_sq += (double)docs * docs;
+		if (docs > max_docs)
+			max_docs = docs;
+		coalesced += main->servers[i]->coalesced_edits;
+		hits += main->servers[i]->cache->hits;
+		misses += main->servers[i]->cache->misses;
+		cache_bytes += main->servers[i]->cache->used_bytes;
+		if (main->servers[i]->cache->used_bytes > max_cache_bytes)
+			max_cache_bytes = main->servers[i]->cache->used_bytes;
+	}
+
+	double mean = 0, stddev = 0;
+	if (main->nr_servers) {
+		mean = sum / main->nr_servers;
+		stddev = sqrt(sum_sq / main->nr_servers - mean * mean);
+	}
+	fprintf(out, "[Stats] Documents per server: mean %.2f, stddev %.2f, "
+			"max/mean %.2f (%d labels per server)\n", mean, stddev,
+			mean > 0 ? max_docs / mean : 0, main->nr_replicas);
+	if (nr_requests && main->nr_servers)
+		fprintf(out, "[Stats] Requests per server: mean %.2f, max/mean "
+				"%.2f\n", (double)nr_requests / main->nr_servers,
+				(double)max_requests * main->nr_servers / nr_requests);
+	if (main->nr_copies > 1)
+		fprintf(out, "[Stats] Replication: %d copies per document, write "
+				"quorum %d, read quorum %d, %lu copies dropped\n",
+				main->nr_copies, main->write_quorum, main->read_quorum,
+				main->dropped_copies);
+	if (main->hot_keys) {
+		replica_stats *rs = &main->replica_stats;
+		fprintf(out, "[Stats] Hot documents: %d tracked, %lu GETs served by "
+				"replicas, %lu replications, %lu updates, %lu invalidations\n",
+				main->hot_keys->nr_docs, rs->reads, rs->refreshes, rs->updates,
+				rs->invalidations);
+	}
+	fprintf(out, "[Stats] Placement: %s, %lu documents moved by %lu server "
+			"changes\n", placement_name(main->placement ?
+			main->placement->type : PLACEMENT_RING), main->rebalanced_docs,
+			main->server_changes);
+	fprintf(out, "[Stats] Cache: %s, %lu hits, %lu misses, hit ratio "
+			"%.2f%%\n", cache_policy_name(main->cache_config.policy), hits,
+			misses, hits + misses ? 100.0 * hits / (hits + misses) : 0);
+	fprintf(out, "[Stats] Cache bytes: %zu B charged to cached documents, "
+			"%zu B in the largest cache\n", cache_bytes, max_cache_bytes);
+	if (main->cache_config.budget) {
+		cache_budget *budget = main->cache_config.budget;
+		fprintf(out, "[Stats] Cache budget: %zu of %zu B used, %lu documents "
+				"evicted from another server's cache\n", budget->used,
+				budget->limit, budget->evictions);
+	}
+	if (main->load_factor > 0)
+		fprintf(out, "[Stats] Bounded load: factor %.2f, %lu documents "
+				"placed past their owner, %u kept off their owner\n",
+				main->load_factor, main->spilled_docs, main->spilled->size);
+	if (main->coalesce_edits)
+		fprintf(out, "[Stats] Coalesced edits: %lu\n", coalesced);
+	if (main->sink)
+		fprintf(out, "[Stats] Output: %lu write calls\n",
+				main->sink->nr_writes);
+	if (main->migrate_batch) {
+		migration_stats *ms = &main->migration_stats;
+		fprintf(out, "[Stats] Migration: %lu arcs, %lu documents moved in "
+				"%lu steps, %lu pulled on access, %lu requests sent to the "
+				"previous owner, %lu arcs finished early, %d arcs pending\n",
+				ms->arcs, ms->docs_moved, ms->steps, ms->pulled, ms->forwarded,
+				ms->forced, main->nr_migrations);
+	}
+}
+
 /* functie care elibereaza memoria alocata pentru un load balancer
 */
 void free_load_balancer(load_balancer **main) {
+	// workerii se opresc inaintea eliberarii serverelor
+	if ((*main)->workers)
+		free_worker_pool(&(*main)->workers);
+
 	// se elibereaza memoria pentru toate serverele
-	for (int i = 0; i < (*main)->nr_servers; i++)
-		free_server(&(*main)->servers[i]);
+	for (int i = 0; i < (*main)->nr_slots; i++)
+		if ((*main)->servers[i])
+			free_server(&(*main)->servers[i]);
+	free_retiring_server(*main);
+	free((*main)->migrations);
+	// cache-urile serverelor au iesit deja din memoria comuna
+	if ((*main)->cache_config.budget)
+		free_cache_budget(&(*main)->cache_config.budget);
 
 	// se elibereaza memoria vectorilor si a structurii principale
-	free((*main)->tag_to_index);
+	free((*main)->free_slots);
+	if ((*main)->spilled)
+		ht_free((*main)->spilled);
+	if ((*main)->hot_keys)
+		free_hot_keys(&(*main)->hot_keys);
+	if ((*main)->placement)
+		free_placement(&(*main)->placement);
+	free((*main)->batch);
 	free((*main)->s_tags);
 	free((*main)->servers);
 	free(*main);
@@ -5,23 +5,160 @@
 #ifndef LOAD_BALANCER_H
 #define LOAD_BALANCER_H
 
+#include "hot_keys.h"
+#include "placement.h"
 #include "server.h"
+#include "server_workers.h"
 
-#define MAX_SERVERS 99999
+// eticheta replicii r a serverului id este r * REPLICA_LABEL_STEP + id,
+// pentru id-urile mai mici decat REPLICA_LABEL_STEP
+#define REPLICA_LABEL_STEP 100000
+// capacitatea initiala a vectorului de servere si a hash ring-ului
+#define INITIAL_SLOTS 8
+// numarul implicit de etichete per server cand vnodes sunt activate
+#define VNODES_REPLICAS 3
+#define MAX_VNODES_REPLICAS 100
+// numarul implicit de documente verificate la un pas al sweeper-ului, cand
+// documentele sunt mutate la primul acces
+#define LAZY_SWEEP_BATCH 16
+// dimensiunea initiala a indexului documentelor plasate in afara
+// proprietarului, cu incarcarea limitata
+#define SPILLED_INIT_SIZE 64
+// numarul maxim de copii ale unui document, cu replicarea
+#define MAX_COPIES 8
+
+/* destinatia unui request dintr-un batch si pozitia lui in batch
+*/
+typedef struct forward_slot {
+	server *s;
+	int pos;
+} forward_slot;
+
+/* un arc al serverului src ale carui documente sunt mutate treptat pe noii
+ * lor proprietari; cursorul este urmatorul document verificat
+*/
+typedef struct migration {
+	server *src;
+	db_arc *arc;
+	// pozitiile de pe ring [lo, hi) care si-au schimbat proprietarul; daca
+	// lo == hi, intregul ring
+	unsigned int lo;
+	unsigned int hi;
+	dll_node_t *cursor;
+	// cursorul este pus la inceputul arcului la primul pas
+	bool started;
+} migration;
+
+typedef struct migration_stats {
+	// arcele migrate si documentele mutate
+	unsigned long arcs;
+	unsigned long docs_moved;
+	// pasii executati intre requesturi
+	unsigned long steps;
+	// requesturile trimise vechiului proprietar al documentului
+	unsigned long forwarded;
+	// documentele aduse la noul proprietar la primul acces
+	unsigned long pulled;
+	// arcele terminate fortat, de o noua schimbare de servere
+	unsigned long forced;
+} migration_stats;
+
+typedef struct replica_stats {
+	// GET-urile servite de replici
+	unsigned long reads;
+	// copierile documentelor fierbinti pe replici
+	unsigned long refreshes;
+	// EDIT-urile scrise direct in replici
+	unsigned long updates;
+	// replicile sterse la o schimbare de servere sau cand documentul nu
+	// mai este fierbinte
+	unsigned long invalidations;
+} replica_stats;
 
 typedef struct load_balancer {
 	unsigned int (*hash_function_servers)(void *);
 	unsigned int (*hash_function_docs)(void *);
-	// vectorul de servere si dimensiunea acestuia
+	// vectorul de servere; un server isi pastreaza slotul pana este
+	// eliminat, iar sloturile libere (NULL) sunt refolosite
 	server **servers;
+	// numarul de sloturi folosite vreodata si capacitatea vectorului
+	int nr_slots;
+	int slots_cap;
+	// stiva sloturilor libere, aflate sub nr_slots
+	int *free_slots;
+	int nr_free;
+	// numarul de servere existente; slotul unui server este gasit pe ring,
+	// dupa pozitia primei lui etichete
 	int nr_servers;
 
 	bool enable_vnodes;
-	// vectorul de etichete pentru servere, pt hash ring
-	int *s_tags;
-	// vectorul care face legatura intre o eticheta si indexul ei in
-	// vectorul de servere
-	int *tag_to_index;
+	// numarul de etichete (replici) pe care le are fiecare server pe ring
+	int nr_replicas;
+	// daca serverele comaseaza EDIT-urile din coada pentru acelasi document
+	bool coalesce_edits;
+	// EDIT-urile comasate de serverele care au fost deja eliminate
+	unsigned long coalesced_edits;
+	// sink-ul in care serverele scriu raspunsurile
+	response_sink *sink;
+	// workerii care executa requesturile serverelor, NULL in modul serial
+	worker_pool *workers;
+	// vectorul refolosit de loader_forward_batch si capacitatea lui
+	forward_slot *batch;
+	int batch_cap;
+	// numarul de documente verificate la un pas de migrare; 0 inseamna ca
+	// documentele sunt mutate imediat, la adaugarea sau eliminarea unui
+	// server
+	unsigned int migrate_batch;
+	// daca un document aflat pe un arc in migrare este adus pe noul
+	// proprietar la primul acces; pasii de migrare doar muta documentele
+	// neaccesate
+	bool lazy_migration;
+	// arcele aflate in migrare, in ordinea in care sunt procesate
+	migration *migrations;
+	int nr_migrations;
+	// serverul eliminat ale carui documente sunt inca in migrare
+	server *retiring;
+	migration_stats migration_stats;
+	// hash ring-ul: pozitiile etichetelor serverelor, impreuna cu slotul
+	// serverului, sortate crescator dupa hash, numarul si capacitatea lor
+	ring_point *s_tags;
+	int nr_tags;
+	int tags_cap;
+	// strategia care plaseaza documentele pe servere; NULL pentru hash
+	// ring, care ramane si indexul id -> slot al serverelor
+	placement *placement;
+	// documentele mutate la adaugarea si eliminarea serverelor si numarul
+	// acestor schimbari
+	unsigned long rebalanced_docs;
+	unsigned long server_changes;
+	// factorul c al incarcarii limitate: un document nou nu este creat pe
+	// un server care are cel putin c ori media documentelor per server;
+	// 0 daca incarcarea nu este limitata
+	double load_factor;
+	// documentele create pe alt server decat proprietarul lor de pe ring,
+	// nume -> slotul serverului care le tine
+	hashtable_t *spilled;
+	// documentele din database-urile serverelor, numarate in modul serial
+	unsigned long stored_docs;
+	// documentele plasate pe un succesor al proprietarului
+	unsigned long spilled_docs;
+	// documentele cel mai des accesate, replicate read-only pe urmatoarele
+	// hot_replicas servere de pe ring; NULL daca nu sunt replicate
+	hot_keys *hot_keys;
+	int hot_replicas;
+	replica_stats replica_stats;
+	// numarul de servere distincte, urmatoarele de pe ring, care tin
+	// fiecare document; un EDIT este confirmat dupa write_quorum copii,
+	// iar un GET este servit de cea mai putin incarcata dintre primele
+	// read_quorum copii
+	int nr_copies;
+	int write_quorum;
+	int read_quorum;
+	// copiile sterse de pe serverele care nu mai tin documentul
+	unsigned long dropped_copies;
+	// politica de eliminare a cache-urilor serverelor adaugate, unitatea
+	// dimensiunii lor si memoria comuna a acestora (NULL daca nu exista)
+	cache_config cache_config;
 } load_balancer;
 
 load_balancer *init_load_balancer(bool enable_vnodes);
@@ -57,6 +194,105 @@ void loader_add_server(load_balancer *main, int server_id, int cache_size);
  */
 void loader_remove_server(load_balancer *main, int server_id);
 
+/**
+ * loader_migrate_step() - Runs one step of the pending migration: drains
+ *      the queue of the source server, then checks up to migrate_batch
+ *      documents of the arc being migrated and moves those owned by another
+ *      server. Does nothing if no migration is pending.
+ *
+ * @brief With migrate_batch set, adding or removing a server only flips
+ *      the ownership of the affected arcs on the ring. Until an arc is
+ *      migrated, requests for its documents that were not moved yet are
+ *      still sent to the previous owner. Steps are meant to run between
+ *      client requests.
+ */
+void loader_migrate_step(load_balancer *main);
+
+/**
+ * loader_set_lazy_migration() - Makes documents on migrating arcs move to
+ *      their new owner on first access: the request is then served by the
+ *      new owner, and migration steps only sweep the documents nobody
+ *      touched. If no migration batch is set, LAZY_SWEEP_BATCH is used.
+ */
+void loader_set_lazy_migration(load_balancer *main);
+
+/**
+ * loader_finish_migrations() - Runs migration steps until no arc is left.
+ */
+void loader_finish_migrations(load_balancer *main);
+
+/**
+ * loader_set_placement() - Places documents with the given strategy
+ *      instead of the hash ring. Must be called before any server is added.
+ *      Each strategy moves, on a server change, only the documents of the
+ *      servers it reports as changed; migrate_batch is not supported.
+ */
+void loader_set_placement(load_balancer *main, placement_type type);
+
+/**
+ * loader_set_cache_policy() - Makes the caches of the servers added from
+ *      now on evict documents by the given policy instead of LRU.
+ */
+void loader_set_cache_policy(load_balancer *main, cache_policy policy);
+
+/**
+ * loader_set_cache_bytes() - Makes the cache size given to the servers
+ *      added from now on a number of bytes instead of documents. Each
+ *      cached document is charged for its name, its content and the cache
+ *      metadata.
+ */
+void loader_set_cache_bytes(load_balancer *main);
+
+/**
+ * loader_set_cache_budget() - Caps the bytes of all server caches at
+ *      limit. When a document no longer fits, documents are evicted from
+ *      the cache holding the most bytes. Must be called before any server
+ *      is added, and not with workers, since a cache may evict documents
+ *      of another server.
+ */
+void loader_set_cache_budget(load_balancer *main, size_t limit);
+
+/**
+ * loader_set_bounded_load() - Caps the load of the ring servers: a new
+ *      document whose owner already stores at least ceil(c * (documents +
+ *      1) / servers) documents is created on the next server along the
+ *      ring below that bound. Such documents are remembered by name, so
+ *      later requests for them follow the same placement.
+ *
+ * @param load_factor: The factor c, at least 1.
+ */
+void loader_set_bounded_load(load_balancer *main, double load_factor);
+
+/**
+ * loader_set_hot_replicas() - Tracks how often each document is requested
+ *      and replicates the hottest ones, read-only, to the next nr_replicas
+ *      servers along the ring. GETs for a replicated document are spread
+ *      round-robin over its owner and the replicas. An EDIT replaces the
+ *      whole content, so it is written to the replicas at once, while the
+ *      owner still runs it lazily from its queue.
+ */
+void loader_set_hot_replicas(load_balancer *main, int nr_replicas);
+
+/**
+ * loader_set_replication() - Stores every document on the first nr_copies
+ *      distinct servers found along the ring from its position. An EDIT
+ *      is queued on the first copy and applied at once on the others;
+ *      with workers, it is acknowledged once write_quorum copies have
+ *      received it. A GET is served by the copy with the fewest requests
+ *      among the first read_quorum ones.
+ *
+ * @brief Every copy receives every EDIT of the document, in order, so any
+ *      copy answers a GET with the latest content. Only the first copy
+ *      queues EDITs and reports them, once each; a GET served by another
+ *      copy runs the first copy's queue before it.
+ *      Removing a server copies each of its documents to the server that
+ *      takes its place in the document's copy set; adding one copies the
+ *      documents it now holds and drops them from the server that no
+ *      longer does.
+ */
+void loader_set_replication(load_balancer *main, int nr_copies,
+							int write_quorum, int read_quorum);
+
 /**
  * loader_forward_request() - Forwards a request to the appropriate server.
  *
@@ -74,4 +310,43 @@ void loader_remove_server(load_balancer *main, int server_id);
  */
 response *loader_forward_request(load_balancer *main, request *req);
 
+/**
+ * loader_forward_batch() - Forwards several requests at once. All requests
+ *      are routed first, then grouped by destination server, and the
+ *      requests of each server are run back to back, in their input order.
+ *
+ * @param reqs: Requests to be forwarded; the caller keeps ownership.
+ * @param nr_reqs: Number of requests.
+ * @param resps: Filled with the response list of each request, in input
+ *      order, as returned by server_handle_request().
+ */
+void loader_forward_batch(load_balancer *main, request *reqs, int nr_reqs,
+						  response **resps);
+
+/**
+ * loader_forward_async() - Like loader_forward_request(), but queues the
+ *      request on the worker owning the target server and returns at once.
+ *      Requires main->workers. The output of the request is written to
+ *      main->sink, in submission order, once it is retired by the pool.
+ *
+ * @param owned: If true, the name and content of req are freed by the pool
+ *      after the request has run; otherwise they must stay valid until
+ *      then.
+ *
+ * @return request_future*: Future of the request, valid until retired.
+ */
+request_future *loader_forward_async(load_balancer *main, request *req,
+									 bool owned);
+
+/**
+ * loader_print_stats() - Prints, for every server, the number of stored
+ *      documents and received requests, followed by the mean, the standard
+ *      deviation and the max/mean ratio of the documents-per-server
+ *      distribution and the max/mean ratio of the requests per server.
+ *
+ * @param main: Load balancer whose servers are reported.
+ * @param out: Stream the report is written to.
+ */
+void loader_print_stats(load_balancer *main, FILE *out);
+
 #endif /* LOAD_BALANCER_H */
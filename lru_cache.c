@@ -10,192 +10,716 @@
 #include "list_queue_hashtable_functions.h"
 #include "utils.h"
 
-/* functie care initializeaza lru cache, precum si toate campurile lui
+// listele folosite de fiecare politica; LRU si CLOCK au o singura lista
+enum {
+	LIST_RECENT = 0,
+	// 2Q: FIFO-ul intrarilor noi, LRU-ul celor reaccesate si fantomele
+	LIST_IN = 0,
+	LIST_MAIN = 1,
+	LIST_OUT = 2,
+	// ARC: intrarile accesate o data (T1), de mai multe ori (T2) si
+	// fantomele fiecareia (B1, B2)
+	LIST_T1 = 0,
+	LIST_T2 = 1,
+	LIST_B1 = 2,
+	LIST_B2 = 3,
+	// W-TinyLFU: fereastra si cele doua segmente ale cache-ului principal
+	LIST_WINDOW = 0,
+	LIST_PROBATION = 1,
+	LIST_PROTECTED = 2,
+};
+
+static const char *cache_policy_names[CACHE_POLICIES] = {
+	"lru", "clock", "2q", "arc", "tinylfu",
+};
+
+int cache_policy_parse(const char *name) {
+	for (int i = 0; i < CACHE_POLICIES; i++)
+		if (!strcmp(name, cache_policy_names[i]))
+			return i;
+	return -1;
+}
+
+const char *cache_policy_name(cache_policy policy) {
+	return cache_policy_names[policy];
+}
+
+/* functie care returneaza un procent din capacitatea cache-ului, cel putin 1
+*/
+static unsigned int share(unsigned int capacity, unsigned int percent) {
+	unsigned int n = (unsigned long)capacity * percent / 100;
+	return n ? n : 1;
+}
+
+cache_budget *init_cache_budget(size_t limit) {
+	cache_budget *budget = calloc(1, sizeof(cache_budget));
+	DIE(budget == NULL, "Failed to allocate memory\n");
+	budget->limit = limit;
+	return budget;
+}
+
+void free_cache_budget(cache_budget **budget) {
+	free((*budget)->caches);
+	free(*budget);
+	*budget = NULL;
+}
+
+/* functie care adauga un cache in lista cache-urilor care impart memoria
 */
-lru_cache *init_lru_cache(unsigned int cache_capacity) {
-	lru_cache *cache = malloc(sizeof(lru_cache));
+static void budget_attach(cache_budget *budget, lru_cache *cache) {
+	if (budget->nr_caches == budget->caches_cap) {
+		budget->caches_cap = budget->caches_cap ? 2 * budget->caches_cap : 8;
+		budget->caches = realloc(budget->caches, budget->caches_cap *
+								 sizeof(lru_cache *));
+		DIE(budget->caches == NULL, "Failed to allocate memory\n");
+	}
+	budget->caches[budget->nr_caches++] = cache;
+}
+
+/* functie care scoate un cache din lista cache-urilor care impart memoria
+*/
+static void budget_detach(cache_budget *budget, lru_cache *cache) {
+	for (int i = 0; i < budget->nr_caches; i++)
+		if (budget->caches[i] == cache) {
+			budget->caches[i] = budget->caches[--budget->nr_caches];
+			return;
+		}
+}
+
+/* functie care initializeaza cache-ul, precum si toate campurile lui
+*/
+lru_cache *init_lru_cache(unsigned int cache_capacity,
+						  const cache_config *config) {
+	lru_cache *cache = calloc(1, sizeof(lru_cache));
 	DIE(cache == NULL, "Failed to allocate memory\n");
 
-	cache->lru_ht = ht_create(cache_capacity, hash_string, compare_function,
-							  key_val_free_function);
-	cache->lru_dll = dll_create(sizeof(info));
+	cache->policy = config->policy;
+	cache->in_bytes = config->in_bytes;
+	// limita politicilor este in aceeasi unitate ca a capacitatii
+	unsigned int limit = cache_capacity;
+	if (cache->in_bytes) {
+		cache->max_bytes = cache_capacity;
+		cache_capacity = cache_capacity / CACHE_EST_ENTRY_BYTES;
+		if (cache_capacity == 0)
+			cache_capacity = 1;
+	}
+	cache->lru_ht = ht_create_ref(cache->in_bytes ? CACHE_HT_INIT_SIZE :
+								  cache_capacity, hash_string,
+								  compare_function);
+	cache->capacity = cache_capacity;
+	if (cache->policy == CACHE_2Q) {
+		cache->in_capacity = share(limit, CACHE_2Q_IN_PERCENT);
+		cache->out_capacity = share(limit, CACHE_2Q_OUT_PERCENT);
+	} else if (cache->policy == CACHE_TINYLFU) {
+		cache->in_capacity = share(limit, CACHE_WINDOW_PERCENT);
+		cache->out_capacity = (unsigned long)(limit - cache->in_capacity) *
+							  CACHE_PROTECTED_PERCENT / 100;
+		// cel putin un contor pe intrare pe fiecare rand, intr-o putere a
+		// lui 2
+		cache->sketch_width = 16;
+		while (cache->sketch_width < cache_capacity)
+			cache->sketch_width <<= 1;
+		cache->sketch = calloc(CACHE_SKETCH_DEPTH * cache->sketch_width,
+							   sizeof(unsigned char));
+		DIE(cache->sketch == NULL, "Failed to allocate memory\n");
+	}
+
+	cache->budget = config->budget;
+	if (cache->budget)
+		budget_attach(cache->budget, cache);
 	return cache;
 }
 
 /* functie care verifica daca cache-ul este plin
 */
 bool lru_cache_is_full(lru_cache *cache) {
-	return cache->lru_ht->size == cache->lru_ht->hmax;
+	if (cache->in_bytes)
+		return cache->used_bytes >= cache->max_bytes;
+	return cache->size == cache->capacity;
 }
+
 /* functie care elibereaza memoria alocata pentru cache si toate campurile lui
 */
 void free_lru_cache(lru_cache **cache) {
-	// se elibereaza memoria alocata pentru toate nodurile din lista
-	dll_node_t *node = (*cache)->lru_dll->head;
-	while (node != NULL) {
-		dll_node_t *aux = node;
-		node = node->next;
-		// se elibereaza campurile din nod
-		key_val_free_function(aux->data);
-		free(aux->data);
-		free(aux);
-		aux = NULL;
-	}
-	// se elibereaza memoria alocata pentru lista dublu inlantuita
-	free((*cache)->lru_dll);
-
-	// se elibereaza memoria alocata pentru hashtable
+	// fiecare intrare se afla intr-o singura lista, deci se elibereaza
+	// parcurgand listele
+	for (int i = 0; i < CACHE_LISTS; i++) {
+		lru_entry *entry = (*cache)->lists[i].head;
+		while (entry != NULL) {
+			lru_entry *aux = entry;
+			entry = entry->next;
+			if (aux->ghost)
+				free(aux->key);
+			free(aux);
+		}
+	}
+	// memoria intrarilor ramase este eliberata si din memoria comuna
+	if ((*cache)->budget) {
+		(*cache)->budget->used -= (*cache)->used_bytes;
+		budget_detach((*cache)->budget, *cache);
+	}
 	ht_free((*cache)->lru_ht);
-
-	// se elibereaza memoria alocata pentru cache
+	free((*cache)->sketch);
 	free(*cache);
+	*cache = NULL;
 }
 
-/* functie care adauga un nou element in cache, verificand daca cheia exista
-* deja in cache
-* daca cache-ul este plin, elimina cel mai vechi accesat element
+/* functie care returneaza memoria ocupata de cache: structura, hashtable-ul,
+ * intrarile, cheile fantomelor si sketch-ul
 */
-bool lru_cache_put(lru_cache *cache, void *key, void *value,
-				   void **evicted_key) {
-	// se calculeaza hash-ul cheii
-	unsigned int hash = cache->lru_ht->hash_function(key);
-	hash %= cache->lru_ht->hmax;
-
-	if (ht_has_key(cache->lru_ht, key)) {
-		// daca cheia exista deja in cache, se actualizeaza continutul si
-		// ordinea in lista de recente
-		// se cauta cheia in hashtable
-		dll_node_t *aux = cache->lru_ht->buckets[hash]->head;
-		while (aux != NULL) {
-			if (cache->lru_ht->compare_function(((info *)aux->data)->key,
-												key) == 0) {
-				// actualizez lista de recente
-				dll_node_t *to_modify = ((info *)aux->data)->value;
-				// modificarea "valorii" din ht consta in modificarea valorii
-				// nodului din lista de recente, adica eliminarea lui si
-				// adaugarea lui la final
-				dll_remove_node(cache->lru_dll, to_modify);
-				dll_add_nth_node(cache->lru_dll, cache->lru_dll->size,
-								 to_modify->data);
-				// cheia exista deja in cache, returnam false
-				return false;
-			}
-			aux = aux->next;
+size_t lru_cache_memory_usage(lru_cache *cache) {
+	return sizeof(lru_cache) + ht_memory_usage(cache->lru_ht) +
+		   cache->lru_ht->size * sizeof(lru_entry) + cache->ghost_bytes +
+		   CACHE_SKETCH_DEPTH * cache->sketch_width;
+}
+
+/* functie care returneaza bytes de care are nevoie intrarea unei chei:
+ * intrarea, slotul si octetul de control din hashtable, cheia si valoarea
+*/
+static size_t entry_charge(void *key, size_t value_size) {
+	return sizeof(lru_entry) + sizeof(ht_slot) + 1 + strlen(key) + 1 +
+		   value_size;
+}
+
+/* functie care returneaza incarcarea unei liste, in unitatea capacitatii:
+ * intrari sau bytes
+*/
+static size_t list_load(lru_cache *cache, int list_id) {
+	lru_list *list = &cache->lists[list_id];
+	return cache->in_bytes ? list->bytes : list->size;
+}
+
+/* functie care verifica daca o intrare de charge bytes depaseste limita
+ * cache-ului sau a memoriei comune; pentru charge 0, intrarea este deja
+ * adaugata
+*/
+static bool lru_over(lru_cache *cache, size_t charge) {
+	bool over = cache->in_bytes ?
+				cache->used_bytes + charge > cache->max_bytes :
+				cache->size + (charge > 0) > cache->capacity;
+	return over || (cache->budget &&
+					cache->budget->used + charge > cache->budget->limit);
+}
+
+/* functie care scoate o intrare din lista ei
+*/
+static void lru_unlink(lru_cache *cache, lru_entry *entry) {
+	lru_list *list = &cache->lists[entry->list];
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		list->head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		list->tail = entry->prev;
+	list->size--;
+	list->bytes -= entry->charge;
+}
+
+/* functie care adauga o intrare la finalul unei liste, ca cea mai recenta
+ * intrare a acesteia
+*/
+static void lru_append(lru_cache *cache, lru_entry *entry, int list_id) {
+	lru_list *list = &cache->lists[list_id];
+	entry->list = list_id;
+	entry->next = NULL;
+	entry->prev = list->tail;
+	if (list->tail)
+		list->tail->next = entry;
+	else
+		list->head = entry;
+	list->tail = entry;
+	list->size++;
+	list->bytes += entry->charge;
+}
+
+/* functie care muta o intrare la finalul unei liste
+*/
+static void lru_move(lru_cache *cache, lru_entry *entry, int list_id) {
+	if (entry->list == list_id && entry == cache->lists[list_id].tail)
+		return;
+	lru_unlink(cache, entry);
+	lru_append(cache, entry, list_id);
+}
+
+/* functie care adauga sau scade bytes ocupati de intrarile cache-ului
+*/
+static void lru_charge(lru_cache *cache, size_t add, size_t sub) {
+	cache->used_bytes = cache->used_bytes + add - sub;
+	if (cache->budget)
+		cache->budget->used = cache->budget->used + add - sub;
+}
+
+/* functie care elimina o intrare din hashtable si din lista ei si
+ * elibereaza memoria acesteia
+*/
+static void lru_delete(lru_cache *cache, lru_entry *entry) {
+	// acul ceasului trece pe intrarea urmatoare, circular
+	if (entry == cache->hand) {
+		cache->hand = entry->next ? entry->next :
+					  cache->lists[LIST_RECENT].head;
+		if (cache->hand == entry)
+			cache->hand = NULL;
+	}
+	ht_remove_entry(cache->lru_ht, entry->key);
+	lru_unlink(cache, entry);
+	if (entry->ghost) {
+		cache->ghost_bytes -= strlen(entry->key) + 1;
+		free(entry->key);
+	} else {
+		cache->size--;
+		lru_charge(cache, 0, entry->charge);
+	}
+	free(entry);
+}
+
+/* functie care elimina o intrare din cache; prima cheie eliminata la o
+ * adaugare este intoarsa, copiata, prin evicted_key, daca acesta nu este
+ * NULL; daca ghost_list este pozitiv, cheia ramane in acea lista, ca
+ * fantoma
+*/
+static void lru_evict(lru_cache *cache, lru_entry *entry, int ghost_list,
+					  void **evicted_key) {
+	if (evicted_key && *evicted_key == NULL)
+		*evicted_key = copy_string(entry->key, DOC_NAME_LENGTH);
+	if (ghost_list < 0) {
+		lru_delete(cache, entry);
+		return;
+	}
+
+	// cheia cache-ului apartine celui care a adaugat-o, deci fantoma
+	// retine o copie a ei
+	ht_remove_entry(cache->lru_ht, entry->key);
+	entry->key = copy_string(entry->key, DOC_NAME_LENGTH);
+	entry->value = NULL;
+	entry->ghost = true;
+	cache->ghost_bytes += strlen(entry->key) + 1;
+	ht_put(cache->lru_ht, entry->key, 0, entry, 0);
+	lru_move(cache, entry, ghost_list);
+	cache->size--;
+	lru_charge(cache, 0, entry->charge);
+
+	// 2Q pastreaza un numar limitat de fantome
+	if (cache->policy == CACHE_2Q)
+		while (list_load(cache, LIST_OUT) > cache->out_capacity)
+			lru_delete(cache, cache->lists[LIST_OUT].head);
+}
+
+/* functie care creeaza intrarea unei chei noi, la finalul unei liste
+*/
+static lru_entry *lru_insert(lru_cache *cache, void *key, void *value,
+							 size_t charge, int list_id) {
+	// intrarea retine doar referinte la cheie si la valoare
+	lru_entry *entry = malloc(sizeof(lru_entry));
+	DIE(entry == NULL, "Failed to allocate memory\n");
+	entry->key = key;
+	entry->value = value;
+	entry->ghost = false;
+	entry->referenced = false;
+	entry->charge = charge;
+
+	ht_put(cache->lru_ht, entry->key, 0, entry, 0);
+	lru_append(cache, entry, list_id);
+	cache->size++;
+	lru_charge(cache, charge, 0);
+	return entry;
+}
+
+/* functie care gaseste pozitiile unei chei pe randurile sketch-ului;
+ * pozitiile sunt h1 + i * h2 (double hashing), ca la documentele fierbinti
+*/
+static void sketch_cells(lru_cache *cache, void *key,
+						 unsigned char **cells) {
+	unsigned int h1 = hash_string(key);
+	unsigned int h2 = hash_uint(&h1) | 1;
+	for (int i = 0; i < CACHE_SKETCH_DEPTH; i++) {
+		unsigned int col = (h1 + i * h2) & (cache->sketch_width - 1);
+		cells[i] = &cache->sketch[i * cache->sketch_width + col];
+	}
+}
+
+/* functie care returneaza frecventa estimata a unei chei
+*/
+static unsigned int sketch_frequency(lru_cache *cache, void *key) {
+	unsigned char *cells[CACHE_SKETCH_DEPTH];
+	sketch_cells(cache, key, cells);
+	unsigned int min = CACHE_SKETCH_MAX;
+	for (int i = 0; i < CACHE_SKETCH_DEPTH; i++)
+		if (*cells[i] < min)
+			min = *cells[i];
+	return min;
+}
+
+/* functie care numara o accesare a unei chei in sketch; cresc doar
+ * contoarele egale cu minimul, iar dupa CACHE_SKETCH_SAMPLE accesari pe
+ * intrare toate contoarele sunt injumatatite
+*/
+static void sketch_increment(lru_cache *cache, void *key) {
+	unsigned char *cells[CACHE_SKETCH_DEPTH];
+	sketch_cells(cache, key, cells);
+	unsigned int min = CACHE_SKETCH_MAX;
+	for (int i = 0; i < CACHE_SKETCH_DEPTH; i++)
+		if (*cells[i] < min)
+			min = *cells[i];
+	if (min < CACHE_SKETCH_MAX)
+		for (int i = 0; i < CACHE_SKETCH_DEPTH; i++)
+			if (*cells[i] == min)
+				(*cells[i])++;
+
+	if (++cache->sketch_ops >= CACHE_SKETCH_SAMPLE * cache->capacity) {
+		for (unsigned int i = 0; i < CACHE_SKETCH_DEPTH * cache->sketch_width;
+			 i++)
+			cache->sketch[i] >>= 1;
+		cache->sketch_ops = 0;
+	}
+}
+
+/* functie care actualizeaza pozitia unei intrari accesate, dupa politica
+ * cache-ului
+*/
+static void lru_touch(lru_cache *cache, lru_entry *entry) {
+	switch (cache->policy) {
+	case CACHE_CLOCK:
+		// la CLOCK, un HIT doar seteaza bitul de referinta
+		entry->referenced = true;
+		break;
+	case CACHE_2Q:
+		// in A1in, intrarile raman in ordinea adaugarii
+		if (entry->list == LIST_MAIN)
+			lru_move(cache, entry, LIST_MAIN);
+		break;
+	case CACHE_ARC:
+		lru_move(cache, entry, LIST_T2);
+		break;
+	case CACHE_TINYLFU:
+		if (entry->list == LIST_WINDOW) {
+			lru_move(cache, entry, LIST_WINDOW);
+			break;
+		}
+		// o intrare accesata din nou trece in segmentul protejat; cele mai
+		// vechi intrari ale acestuia coboara, daca nu mai au loc
+		lru_move(cache, entry, LIST_PROTECTED);
+		while (list_load(cache, LIST_PROTECTED) > cache->out_capacity &&
+			   cache->lists[LIST_PROTECTED].size > 1)
+			lru_move(cache, cache->lists[LIST_PROTECTED].head,
+					 LIST_PROBATION);
+		break;
+	default:
+		lru_move(cache, entry, LIST_RECENT);
+		break;
+	}
+}
+
+/* functie care returneaza cea mai veche intrare dintr-o lista, alta decat
+ * a si b
+*/
+static lru_entry *first_other(lru_cache *cache, int list_id, lru_entry *a,
+							  lru_entry *b) {
+	lru_entry *entry = cache->lists[list_id].head;
+	while (entry && (entry == a || entry == b))
+		entry = entry->next;
+	return entry;
+}
+
+/* functie care muta acul ceasului pana la prima intrare fara bitul de
+ * referinta, alta decat keep; intrarile sarite isi pierd bitul
+*/
+static lru_entry *clock_victim(lru_cache *cache, lru_entry *keep) {
+	lru_entry *entry = cache->hand;
+	while (entry == keep || entry->referenced) {
+		if (entry != keep)
+			entry->referenced = false;
+		entry = entry->next ? entry->next : cache->lists[LIST_RECENT].head;
+	}
+	cache->hand = entry;
+	return entry;
+}
+
+/* functie care alege intrarea eliminata de politica cache-ului, alta decat
+ * keep, si lista in care ramane cheia ei ca fantoma (-1 daca nu ramane)
+ * in_b2 arata ca intrarea adaugata in ARC era o fantoma din B2, iar
+ * candidate este intrarea iesita din fereastra W-TinyLFU, care ramane doar
+ * daca este mai frecventa decat victima
+*/
+static lru_entry *lru_victim(lru_cache *cache, lru_entry *keep,
+							 lru_entry *candidate, bool in_b2,
+							 int *ghost_list) {
+	*ghost_list = -1;
+	lru_entry *victim;
+	switch (cache->policy) {
+	case CACHE_CLOCK:
+		return clock_victim(cache, keep);
+	case CACHE_2Q:
+		// o intrare din A1in, daca aceasta a depasit dimensiunea ei, ramane
+		// ca fantoma in A1out; altfel se elimina cea mai veche intrare
+		// reaccesata
+		victim = first_other(cache, LIST_IN, keep, NULL);
+		if (victim && (list_load(cache, LIST_IN) > cache->in_capacity ||
+					   !first_other(cache, LIST_MAIN, keep, NULL))) {
+			*ghost_list = LIST_OUT;
+			return victim;
 		}
+		return first_other(cache, LIST_MAIN, keep, NULL);
+	case CACHE_ARC: {
+		// se elimina din T1 sau din T2, dupa dimensiunea tinta a lui T1
+		size_t t1 = list_load(cache, LIST_T1);
+		victim = first_other(cache, LIST_T1, keep, NULL);
+		lru_entry *t2_victim = first_other(cache, LIST_T2, keep, NULL);
+		if (victim && (t1 > cache->target || (in_b2 && t1 == cache->target) ||
+					   !t2_victim)) {
+			*ghost_list = LIST_B1;
+			return victim;
+		}
+		*ghost_list = LIST_B2;
+		return t2_victim;
+	}
+	case CACHE_TINYLFU:
+		victim = first_other(cache, LIST_PROBATION, keep, candidate);
+		if (!victim)
+			victim = first_other(cache, LIST_PROTECTED, keep, candidate);
+		if (candidate && (!victim || sketch_frequency(cache, candidate->key) <=
+						  sketch_frequency(cache, victim->key)))
+			victim = candidate;
+		return victim ? victim : first_other(cache, LIST_WINDOW, keep, NULL);
+	default:
+		// cel mai vechi accesat element
+		return first_other(cache, LIST_RECENT, keep, NULL);
 	}
-	// cheia nu exista in ht, se creaza o intrare noua in ht si in lista
+}
 
-	// verific daca cache e plin
-	if (lru_cache_is_full(cache)) {
-		// elimin cel mai vechi accesat element
-		*evicted_key = (char *)malloc(DOC_NAME_LENGTH * sizeof(char));
-		DIE(*evicted_key == NULL, "Failed to allocate memory\n");
+/* functie care elibereaza memorie comuna pentru o intrare de charge bytes,
+ * eliminand intrari din cache-urile care ocupa mai multi bytes decat cache;
+ * restul memoriei este eliberat chiar din cache
+*/
+static void budget_reclaim(lru_cache *cache, size_t charge) {
+	cache_budget *budget = cache->budget;
+	while (budget && budget->used + charge > budget->limit) {
+		lru_cache *largest = NULL;
+		for (int i = 0; i < budget->nr_caches; i++) {
+			lru_cache *other = budget->caches[i];
+			if (other != cache && other->size > 0 &&
+				(!largest || other->used_bytes > largest->used_bytes))
+				largest = other;
+		}
+		if (!largest || largest->used_bytes <= cache->used_bytes)
+			return;
 
-		snprintf((char *)*evicted_key, DOC_NAME_LENGTH, "%s",
-				 (char *)(((info *)cache->lru_dll->head->data)->key));
-		lru_cache_remove(cache, *evicted_key);
+		int ghost_list;
+		lru_entry *victim = lru_victim(largest, NULL, NULL, false,
+									   &ghost_list);
+		lru_evict(largest, victim, ghost_list, NULL);
+		budget->evictions++;
 	}
+}
 
-	// adaugare nou element in cache, in lista de recente
-	info *new_node = malloc(sizeof(info));
-	DIE(new_node == NULL, "Failed to allocate memory\n");
+/* functie care elimina intrari pana cand o intrare de charge bytes are loc,
+ * fara a elimina intrarea keep
+*/
+static void lru_make_room(lru_cache *cache, size_t charge, lru_entry *keep,
+						  lru_entry *candidate, bool in_b2,
+						  void **evicted_key) {
+	budget_reclaim(cache, charge);
+	while (cache->size > (keep ? 1u : 0u) && lru_over(cache, charge)) {
+		int ghost_list;
+		lru_entry *victim = lru_victim(cache, keep, candidate, in_b2,
+									   &ghost_list);
+		if (victim == NULL)
+			break;
+		if (victim == candidate)
+			candidate = NULL;
+		lru_evict(cache, victim, ghost_list, evicted_key);
+	}
+}
 
-	new_node->key = malloc(DOC_NAME_LENGTH * sizeof(char));
-	DIE(new_node->key == NULL, "Failed to allocate memory\n");
-	memcpy(new_node->key, key, DOC_NAME_LENGTH);
+/* functie care adauga o intrare noua in CLOCK, inaintea acului, deci ea
+ * este verificata ultima
+*/
+static void clock_insert(lru_cache *cache, void *key, void *value,
+						 size_t charge) {
+	lru_entry *entry = lru_insert(cache, key, value, charge, LIST_RECENT);
+	lru_list *list = &cache->lists[LIST_RECENT];
+	lru_entry *hand = cache->hand;
+	if (hand == NULL) {
+		cache->hand = entry;
+		return;
+	}
+	// daca acul este pe prima intrare, finalul listei este chiar inaintea
+	// lui; altfel intrarea este mutata inaintea acului
+	if (hand == list->head)
+		return;
+	lru_unlink(cache, entry);
+	entry->next = hand;
+	entry->prev = hand->prev;
+	hand->prev->next = entry;
+	hand->prev = entry;
+	list->size++;
+	list->bytes += entry->charge;
+}
 
-	new_node->value = malloc(DOC_CONTENT_LENGTH * sizeof(char));
-	DIE(new_node->value == NULL, "Failed to allocate memory\n");
-	memcpy(new_node->value, value, DOC_CONTENT_LENGTH);
+/* functie care adauga o cheie noua in ARC; o fantoma gasita muta tinta lui
+ * T1 spre lista din care a fost eliminata cheia
+*/
+static void arc_put(lru_cache *cache, lru_entry *ghost, void *key,
+					void *value, size_t charge, void **evicted_key) {
+	size_t c = cache->in_bytes ? cache->max_bytes : cache->capacity;
+	size_t b1 = list_load(cache, LIST_B1);
+	size_t b2 = list_load(cache, LIST_B2);
+	if (ghost) {
+		// tinta se muta cu dimensiunea fantomei, inmultita cu raportul
+		// dintre cele doua liste de fantome
+		size_t unit = cache->in_bytes ? ghost->charge : 1;
+		bool in_b2 = ghost->list == LIST_B2;
+		if (in_b2) {
+			size_t delta = unit * (b1 > b2 ? b1 / b2 : 1);
+			cache->target = cache->target > delta ? cache->target - delta : 0;
+		} else {
+			size_t delta = unit * (b2 > b1 ? b2 / b1 : 1);
+			cache->target = cache->target + delta < c ?
+							cache->target + delta : c;
+		}
+		lru_delete(cache, ghost);
+		lru_make_room(cache, charge, NULL, NULL, in_b2, evicted_key);
+		lru_insert(cache, key, value, charge, LIST_T2);
+		return;
+	}
 
-	// se adauga la final, fiind cel mai recent accesat element
-	dll_add_nth_node(cache->lru_dll, cache->lru_dll->size, new_node);
-	free(new_node);
+	size_t t1 = list_load(cache, LIST_T1);
+	size_t resident = cache->in_bytes ? cache->used_bytes : cache->size;
+	if (t1 + b1 >= c) {
+		// istoricul accesarilor unice este plin
+		if (t1 < c) {
+			while (list_load(cache, LIST_T1) + list_load(cache, LIST_B1) >=
+				   c && cache->lists[LIST_B1].head)
+				lru_delete(cache, cache->lists[LIST_B1].head);
+		} else {
+			while (cache->lists[LIST_T1].head && lru_over(cache, charge))
+				lru_evict(cache, cache->lists[LIST_T1].head, -1, evicted_key);
+		}
+	} else if (resident + b1 + b2 >= 2 * c) {
+		while (cache->lists[LIST_B2].head &&
+			   (cache->in_bytes ? cache->used_bytes : cache->size) +
+			   list_load(cache, LIST_B1) + list_load(cache, LIST_B2) >= 2 * c)
+			lru_delete(cache, cache->lists[LIST_B2].head);
+	}
+	lru_make_room(cache, charge, NULL, NULL, false, evicted_key);
+	lru_insert(cache, key, value, charge, LIST_T1);
+}
 
-	// adaugare nou element in cache, in hashtable
-	info *new_node_ht = malloc(sizeof(info));
-	DIE(new_node_ht == NULL, "Failed to allocate memory\n");
+/* functie care adauga o cheie noua in W-TinyLFU: cheia intra in fereastra,
+ * iar cele mai vechi intrari ale ferestrei trec in probation; daca nu mai
+ * este loc, ultima dintre ele ramane doar daca este mai frecventa decat
+ * victima, cea mai veche intrare din probation
+*/
+static void tinylfu_put(lru_cache *cache, void *key, void *value,
+						size_t charge, void **evicted_key) {
+	lru_entry *entry = lru_insert(cache, key, value, charge, LIST_WINDOW);
+	lru_entry *candidate = NULL;
+	while (list_load(cache, LIST_WINDOW) > cache->in_capacity &&
+		   cache->lists[LIST_WINDOW].size > 1) {
+		candidate = cache->lists[LIST_WINDOW].head;
+		lru_move(cache, candidate, LIST_PROBATION);
+	}
+	lru_make_room(cache, 0, entry, candidate, false, evicted_key);
+}
 
-	new_node_ht->key = malloc(DOC_NAME_LENGTH * sizeof(char));
-	DIE(new_node_ht->key == NULL, "Failed to allocate memory\n");
-	memcpy(new_node_ht->key, key, DOC_NAME_LENGTH);
+/* functie care adauga un nou element in cache, verificand daca cheia exista
+* deja in cache
+* daca nu mai este loc, elimina elementele alese de politica lui
+*/
+bool lru_cache_put(lru_cache *cache, void *key, void *value,
+				   size_t value_size, void **evicted_key) {
+	lru_entry *entry = ht_get(cache->lru_ht, key);
+	if (entry && !entry->ghost) {
+		// daca cheia exista deja in cache, se actualizeaza referinta la
+		// valoare si pozitia intrarii
+		entry->value = value;
+		lru_touch(cache, entry);
+		lru_cache_resize(cache, key, value_size);
+		// cheia exista deja in cache, returnam false
+		return false;
+	}
+	// cheia nu exista in cache, se creaza o intrare noua
+	size_t charge = entry_charge(key, value_size);
 
-	// in ht valoarea este un pointer catre nodul cel mai recent din lista,
-	// adaugat mai sus
-	new_node_ht->value = cache->lru_dll->tail;
-	// se adauga in lista de valori a bucket-ului corespunzator
-	dll_add_nth_node(cache->lru_ht->buckets[hash],
-					 cache->lru_ht->buckets[hash]->size, new_node_ht);
+	switch (cache->policy) {
+	case CACHE_CLOCK:
+		lru_make_room(cache, charge, NULL, NULL, false, evicted_key);
+		clock_insert(cache, key, value, charge);
+		break;
+	case CACHE_2Q:
+		// o cheie care mai era fantoma a fost accesata de doua ori si intra
+		// direct in lista LRU
+		if (entry)
+			lru_delete(cache, entry);
+		lru_make_room(cache, charge, NULL, NULL, false, evicted_key);
+		lru_insert(cache, key, value, charge, entry ? LIST_MAIN : LIST_IN);
+		break;
+	case CACHE_ARC:
+		arc_put(cache, entry, key, value, charge, evicted_key);
+		break;
+	case CACHE_TINYLFU:
+		tinylfu_put(cache, key, value, charge, evicted_key);
+		break;
+	default:
+		// se elimina cele mai vechi accesate elemente, iar intrarea este
+		// cel mai recent accesat element
+		lru_make_room(cache, charge, NULL, NULL, false, evicted_key);
+		lru_insert(cache, key, value, charge, LIST_RECENT);
+		break;
+	}
 
-	free(new_node_ht);
-	// se actualizeaza numarul de noduri din hashtable
-	cache->lru_ht->size++;
 	// cheia nu exista in cache, returnam true
 	return true;
 }
 
+/* functie care actualizeaza memoria ocupata de valoarea unei chei din cache
+ * si elimina alte intrari, daca aceasta nu mai are loc
+*/
+void lru_cache_resize(lru_cache *cache, void *key, size_t value_size) {
+	lru_entry *entry = ht_get(cache->lru_ht, key);
+	if (entry == NULL || entry->ghost)
+		return;
+
+	size_t charge = entry_charge(key, value_size);
+	cache->lists[entry->list].bytes += charge - entry->charge;
+	lru_charge(cache, charge, entry->charge);
+	entry->charge = charge;
+	// cheile eliminate astfel nu apar in log, deci sunt doar eliberate
+	void *evicted_key = NULL;
+	lru_make_room(cache, 0, entry, NULL, false, &evicted_key);
+	free(evicted_key);
+}
+
 /* functie care returneaza valoarea asociata unei chei, daca aceasta exista in
 * cache
 */
 void *lru_cache_get(lru_cache *cache, void *key) {
-	// se calculeaza hash-ul cheii
-	unsigned int hash = cache->lru_ht->hash_function(key);
-	hash %= cache->lru_ht->hmax;
-
-	dll_node_t *aux = cache->lru_ht->buckets[hash]->head;
-	while (aux != NULL) {
-		if (cache->lru_ht->compare_function(((info *)aux->data)->key, key) ==
-			0) {
-			// daca cheia exista in cache, se actualizeaza ordinea in lista de
-			// recente
-			dll_node_t *to_move = ((info *)aux->data)->value;
-			dll_remove_node(cache->lru_dll, to_move);
-			dll_add_nth_node(cache->lru_dll, cache->lru_dll->size,
-							 to_move->data);
-			free(to_move->data);
-			free(to_move);
-			// se actualizeaza "valoarea" din hashtable, adica pointerul catre
-			// nodul din lista de recente
-			((info *)aux->data)->value = cache->lru_dll->tail;
-			// se returneaza valoarea asociata cheii
-			return ((info *)aux->data)->value;
-		}
-		aux = aux->next;
+	// W-TinyLFU numara toate accesarile, inclusiv cele ale cheilor care nu
+	// sunt in cache
+	if (cache->sketch)
+		sketch_increment(cache, key);
+
+	lru_entry *entry = ht_get(cache->lru_ht, key);
+	if (entry == NULL || entry->ghost) {
+		// se returneaza NULL daca cheia nu exista in cache
+		cache->misses++;
+		return NULL;
 	}
-	// se returneaza NULL daca cheia nu exista in cache
-	return NULL;
+
+	cache->hits++;
+	lru_touch(cache, entry);
+	return entry->value;
 }
 
 /* functie care elimina un element din cache
 */
 void lru_cache_remove(lru_cache *cache, void *key) {
-	// se calculeaza hash-ul cheii
-	unsigned int hash = cache->lru_ht->hash_function(key);
-	hash %= cache->lru_ht->hmax;
-
-	dll_node_t *aux = cache->lru_ht->buckets[hash]->head;
-	while (aux != NULL) {
-		if (cache->lru_ht->compare_function(((info *)aux->data)->key, key) ==
-			0) {
-			// se elimina elementul din lista de recente si se elibereaza
-			// memoria alocata
-			dll_node_t *to_remove = ((info *)aux->data)->value;
-			dll_remove_node(cache->lru_dll, to_remove);
-			cache->lru_ht->key_val_free_function(to_remove->data);
-			free(to_remove->data);
-			free(to_remove);
-
-			// se elimina elementul din hashtable si se elibereaza memoria
-			// alocata
-			dll_remove_node(cache->lru_ht->buckets[hash], aux);
-			if (((info *)aux->data)->key)
-				free(((info *)aux->data)->key);
-			free(aux->data);
-			free(aux);
-			// se actualizeaza numarul de noduri din hashtable
-			cache->lru_ht->size--;
-			return;
-		}
-		aux = aux->next;
-	}
+	lru_entry *entry = ht_get(cache->lru_ht, key);
+	if (entry == NULL)
+		return;
+
+	// se elimina elementul din hashtable si din lista lui si se elibereaza
+	// memoria intrarii
+	lru_delete(cache, entry);
 }
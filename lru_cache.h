@@ -6,40 +6,209 @@
 #define LRU_CACHE_H
 #include <stdbool.h>
 
+#include "constants.h"
 #include "structs.h"
 
-/* lru cache este implementat printr-un hashtable unde cheia este numele
-* documentului si valoarea este un pointer la un nod din lista dublu inlantuita
-* care contine informatiile despre document
+// numarul de liste de intrari ale unui cache; fiecare politica foloseste
+// cate are nevoie
+#define CACHE_LISTS 4
+// 2Q: procentul din capacitate pentru coada FIFO a intrarilor noi (A1in)
+// si numarul de chei fantoma (A1out), tot ca procent din capacitate
+#define CACHE_2Q_IN_PERCENT 25
+#define CACHE_2Q_OUT_PERCENT 50
+// W-TinyLFU: procentul din capacitate pentru fereastra LRU si procentul
+// din restul cache-ului pentru segmentul protejat
+#define CACHE_WINDOW_PERCENT 1
+#define CACHE_PROTECTED_PERCENT 80
+// dimensiunile sketch-ului de frecvente al W-TinyLFU: randuri, valoarea
+// maxima a unui contor si numarul de accesari pe intrare dupa care toate
+// contoarele sunt injumatatite
+#define CACHE_SKETCH_DEPTH 4
+#define CACHE_SKETCH_MAX 15
+#define CACHE_SKETCH_SAMPLE 10
+// dimensiunea estimata a unei intrari, folosita doar pentru dimensionarea
+// sketch-ului unui cache limitat in bytes
+#define CACHE_EST_ENTRY_BYTES 128
+// dimensiunea initiala a hashtable-ului unui cache limitat in bytes
+#define CACHE_HT_INIT_SIZE 64
+
+typedef enum cache_policy {
+	// lista de recente, ordonata la fiecare accesare
+	CACHE_LRU,
+	// bit de referinta si ac de ceas, fara relegari la HIT
+	CACHE_CLOCK,
+	// FIFO pentru intrarile noi, LRU pentru cele accesate de doua ori
+	CACHE_2Q,
+	// Adaptive Replacement Cache, cu liste fantoma
+	CACHE_ARC,
+	// fereastra LRU si SLRU, cu admitere dupa un count-min sketch
+	CACHE_TINYLFU,
+	CACHE_POLICIES,
+} cache_policy;
+
+struct lru_cache;
+
+/* memoria comuna a cache-urilor mai multor servere: cand o intrare noua nu
+* mai are loc, se elimina intrari din cache-ul care ocupa cei mai multi bytes
+*/
+typedef struct cache_budget {
+	size_t limit;
+	// bytes ocupati de intrarile tuturor cache-urilor
+	size_t used;
+	// cache-urile care impart memoria
+	struct lru_cache **caches;
+	int nr_caches;
+	int caches_cap;
+	// intrarile eliminate din alt cache decat cel in care s-a adaugat
+	unsigned long evictions;
+} cache_budget;
+
+/* modul in care se creeaza un cache: politica de eliminare, daca
+* dimensiunea lui este in bytes in loc de intrari si memoria comuna din care
+* face parte (NULL daca nu exista)
+*/
+typedef struct cache_config {
+	cache_policy policy;
+	bool in_bytes;
+	cache_budget *budget;
+} cache_config;
+
+/* intrare din cache: aceeasi alocare contine referintele la cheie si la
+* valoare si legaturile din lista in care se afla, astfel incat un HIT
+* inseamna doar refacerea unor legaturi
+* cache-ul nu copiaza si nu elibereaza cheile si valorile; acestea apartin
+* celui care le-a adaugat si trebuie sa ramana valide cat timp sunt in cache
+* intrarile fantoma (2Q si ARC) retin doar o copie a cheii, fara valoare
+*/
+typedef struct lru_entry {
+	void *key;
+	void *value;
+	// vecinii din lista (prev = mai vechi, next = mai recent)
+	struct lru_entry *prev;
+	struct lru_entry *next;
+	// lista in care se afla intrarea
+	unsigned char list;
+	// intrarea a fost eliminata, iar cheia este pastrata doar ca istoric
+	bool ghost;
+	// bitul de referinta al CLOCK, setat la fiecare HIT
+	bool referenced;
+	// bytes ocupati de intrare: intrarea, slotul din hashtable, cheia si
+	// valoarea; o fantoma pastreaza dimensiunea intrarii eliminate
+	size_t charge;
+} lru_entry;
+
+// o lista de intrari; head este cea mai veche, iar tail cea mai recenta
+typedef struct lru_list {
+	lru_entry *head;
+	lru_entry *tail;
+	unsigned int size;
+	// suma dimensiunilor (charge) intrarilor din lista
+	size_t bytes;
+} lru_list;
+
+/* cache-ul este implementat printr-un hashtable cu adresare deschisa, unde
+* cheia este numele documentului, iar valoarea este intrarea din cache, si
+* liste dublu inlantuite ce trec prin aceleasi intrari; politica alege
+* listele folosite si intrarea eliminata cand cache-ul este plin
 */
 typedef struct lru_cache {
+	cache_policy policy;
+	// hashtable-ul retine pointeri la cheile intrarilor, fara copii
 	hashtable_t *lru_ht;
-	dll_t *lru_dll;
+	// nr. maxim de intrari din cache si nr. de intrari (fara fantome); in
+	// modul cu bytes, capacity este doar o estimare
+	unsigned int capacity;
+	unsigned int size;
+	// in modul cu bytes, cache-ul este limitat la max_bytes
+	bool in_bytes;
+	size_t max_bytes;
+	// bytes ocupati de intrari (fara fantome)
+	size_t used_bytes;
+	cache_budget *budget;
+	lru_list lists[CACHE_LISTS];
+	// CLOCK: urmatoarea intrare verificata la eliminare
+	lru_entry *hand;
+	// 2Q: dimensiunea cozii A1in si nr. maxim de fantome; W-TinyLFU:
+	// dimensiunea ferestrei si a segmentului protejat; toate, ca si tinta
+	// ARC, sunt in bytes in modul cu bytes
+	unsigned int in_capacity;
+	unsigned int out_capacity;
+	// ARC: dimensiunea tinta a listei T1
+	unsigned int target;
+	// W-TinyLFU: contoarele sketch-ului, CACHE_SKETCH_DEPTH randuri a cate
+	// sketch_width, si accesarile numarate de la ultima injumatatire
+	unsigned char *sketch;
+	unsigned int sketch_width;
+	unsigned int sketch_ops;
+	// memoria ocupata de cheile copiate ale fantomelor
+	size_t ghost_bytes;
+	unsigned long hits;
+	unsigned long misses;
 } lru_cache;
 
-lru_cache *init_lru_cache(unsigned int cache_capacity);
+/**
+ * cache_policy_parse() - Returns the cache policy called name ("lru",
+ *      "clock", "2q", "arc" or "tinylfu"), or -1 if there is none.
+ */
+int cache_policy_parse(const char *name);
+
+const char *cache_policy_name(cache_policy policy);
+
+/**
+ * init_cache_budget() - Creates a memory budget of limit bytes, to be
+ *      shared by the caches created with it.
+ */
+cache_budget *init_cache_budget(size_t limit);
+
+/**
+ * free_cache_budget() - Frees a budget. Its caches must be freed first.
+ */
+void free_cache_budget(cache_budget **budget);
+
+/**
+ * init_lru_cache() - Creates an empty cache, whose entries are evicted by
+ *      the policy in config.
+ *
+ * @param cache_capacity: Maximum number of entries, or maximum number of
+ *      bytes if config->in_bytes is set.
+ * @param config: Policy, unit of the capacity and shared budget.
+ */
+lru_cache *init_lru_cache(unsigned int cache_capacity,
+						  const cache_config *config);
 
 bool lru_cache_is_full(lru_cache *cache);
 
 void free_lru_cache(lru_cache **cache);
 
 /**
- * lru_cache_put() - Adds a new pair in our cache.
+ * lru_cache_put() - Adds a new pair in our cache. The cache keeps
+ *      references to key and value, which must stay valid until the pair
+ *      is removed or evicted. Entries are evicted until the new one fits,
+ *      unless it is the only one left.
  *
  * @param cache: Cache where the key-value pair will be stored.
  * @param key: Key of the pair.
  * @param value: Value of the pair.
+ * @param value_size: Bytes held by the value, charged to the cache along
+ *      with the key and the entry.
  * @param evicted_key: The function will RETURN via this parameter the
- *      key removed from cache if the cache was full.
+ *      first key removed from cache if the cache was full.
  *
  * @return - true if the key was added to the cache,
  *      false if the key already existed.
  */
 bool lru_cache_put(lru_cache *cache, void *key, void *value,
-				   void **evicted_key);
+				   size_t value_size, void **evicted_key);
 
 /**
- * lru_cache_get() - Retrieves the value associated with a key.
+ * lru_cache_resize() - Updates the bytes held by the value of a cached
+ *      key, evicting other entries if it no longer fits.
+ */
+void lru_cache_resize(lru_cache *cache, void *key, size_t value_size);
+
+/**
+ * lru_cache_get() - Retrieves the value associated with a key and counts
+ *      the access as a hit or a miss.
  *
  * @param cache: Cache where the key-value pair is stored.
  * @param key: Key of the pair.
@@ -50,11 +219,23 @@ bool lru_cache_put(lru_cache *cache, void *key, void *value,
 void *lru_cache_get(lru_cache *cache, void *key);
 
 /**
- * lru_cache_remove() - Removes a key-value pair from the cache.
+ * lru_cache_remove() - Removes a key-value pair from the cache, along with
+ *      the ghost entry of the key, if any.
  *
  * @param cache: Cache where the key-value pair is stored.
  * @param key: Key of the pair.
  */
 void lru_cache_remove(lru_cache *cache, void *key);
 
+/**
+ * lru_cache_memory_usage() - Computes the memory held by the cache.
+ *
+ * @param cache: Cache to be measured.
+ *
+ * @return - Bytes used by the cache structure, its hashtable, its entries,
+ *      the ghost keys and the sketch. Keys and values are owned by the
+ *      caller and not counted.
+ */
+size_t lru_cache_memory_usage(lru_cache *cache);
+
 #endif /* LRU_CACHE_H */
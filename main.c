@@ -3,150 +3,370 @@
  * Copyright (c) 2024, Eduard Marin <marin.eduard.c@gmail.com>
  */
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "constants.h"
 #include "load_balancer.h"
 #include "lru_cache.h"
+#include "request_parser.h"
+#include "response_sink.h"
+#include "spsc_queue.h"
 #include "utils.h"
 
-void read_quoted_string(char *buffer, int buffer_len, int *start, int *end) {
-	*end = -1;
+/* Number of parsed requests which can wait for the routing stage */
+#define PARSED_QUEUE_SIZE 4096
 
-	for (int i = 0; i < buffer_len && buffer[i] != '\0'; ++i) {
-		if (buffer[i] != '"') continue;
-
-		if (*start == -1) {
-			*start = i;
-		} else {
-			*end = i;
-			break;
-		}
+typedef struct run_options {
+	bool enable_vnodes;
+	int nr_replicas;
+	bool print_stats;
+	bool coalesce_edits;
+	bool mmap_input;
+	bool binary_output;
+	bool pipeline;
+	int nr_workers;
+	int batch_size;
+	int migrate_batch;
+	bool lazy_migration;
+	placement_type placement;
+	cache_policy cache_policy;
+	bool cache_bytes;
+	size_t cache_budget;
+	double load_factor;
+	int hot_replicas;
+	int nr_copies;
+	int write_quorum;
+	int read_quorum;
+} run_options;
+
+void *parser_thread(void *arg) {
+	request_parser *parser = arg;
+	parsed_request req;
+
+	for (int i = 0; i < parser->requests_num; i++) {
+		parse_request(parser, &req);
+		spsc_push(parser->parsed, &req);
 	}
+	return NULL;
 }
 
-request_type read_request_arguments(FILE *input_file, char *buffer,
-									int *maybe_server_id, int *maybe_cache_size,
-									char **maybe_doc_name,
-									char **maybe_doc_content) {
-	request_type req_type;
-	int word_start = -1;
-	int word_end = -1;
-
-	DIE(fgets(buffer, REQUEST_LENGTH + 1, input_file) == NULL,
-		"insufficient requests");
-
-	req_type = get_request_type(buffer);
-
-	if (req_type == ADD_SERVER) {
-		*maybe_server_id = atoi(buffer + strlen(ADD_SERVER_REQUEST) + 1);
-		*maybe_cache_size =
-			atoi(strchr(buffer + strlen(ADD_SERVER_REQUEST) + 1, ' '));
-	} else if (req_type == REMOVE_SERVER) {
-		*maybe_server_id = atoi(buffer + strlen(REMOVE_SERVER_REQUEST) + 1);
-	} else {
-		*maybe_doc_name = calloc(1, DOC_NAME_LENGTH + 1);
-		DIE(*maybe_doc_name == NULL, "calloc failed");
-
-		read_quoted_string(buffer, REQUEST_LENGTH, &word_start, &word_end);
-		memcpy(*maybe_doc_name, buffer + word_start + 1,
-			   word_end - word_start - 1);
-
-		if (req_type == EDIT_DOCUMENT) {
-			char *tmp_buffer = buffer + word_end + 1;
-
-			*maybe_doc_content = calloc(1, DOC_CONTENT_LENGTH + 1);
-			DIE(*maybe_doc_content == NULL, "calloc failed");
-
-			/* Read the content, which might be a multiline quoted string */
-			word_start = -1;
-			read_quoted_string(tmp_buffer, DOC_CONTENT_LENGTH, &word_start,
-							   &word_end);
-
-			if (word_end == -1)
-				strcpy(*maybe_doc_content, tmp_buffer + word_start + 1);
-			else
-				strncpy(*maybe_doc_content, tmp_buffer + word_start + 1,
-						word_end - word_start - 1);
-
-			while (word_end == -1) {
-				DIE(fgets(buffer, DOC_CONTENT_LENGTH + 1, input_file) == NULL,
-					"document content is not properly quoted");
-
-				read_quoted_string(buffer, DOC_CONTENT_LENGTH, &word_start,
-								   &word_end);
-				memcpy(*maybe_doc_content + strlen(*maybe_doc_content), buffer,
-					   word_end == -1 ? strlen(buffer) : (unsigned)word_end);
-			}
-		} else {
-			*maybe_doc_content = NULL;
+/* GET and EDIT requests gathered for loader_forward_batch */
+typedef struct request_batch {
+	request *reqs;
+	response **resps;
+	int size;
+	int capacity;
+} request_batch;
+
+void flush_batch(load_balancer *main, request_batch *batch, bool owned) {
+	loader_forward_batch(main, batch->reqs, batch->size, batch->resps);
+
+	for (int i = 0; i < batch->size; i++) {
+		sink_write_response(main->sink, batch->resps[i]);
+		if (owned) {
+			free(batch->reqs[i].doc_name);
+			free(batch->reqs[i].doc_content);
 		}
 	}
-
-	return req_type;
+	batch->size = 0;
+	loader_migrate_step(main);
 }
 
-void apply_requests(FILE *input_file, char *buffer, int requests_num,
-					bool enable_vnodes) {
-	char *doc_name, *doc_content;
-	int server_id, cache_size;
+void route_request(load_balancer *main, parsed_request *req, bool owned,
+				   request_batch *batch) {
+	/* requests gathered so far must run before the servers change */
+	if (batch && batch->size &&
+		(req->type == ADD_SERVER || req->type == REMOVE_SERVER))
+		flush_batch(main, batch, owned);
+
+	if (req->type == ADD_SERVER) {
+		DIE(req->cache_size < 0, "cache size must be positive");
+		loader_add_server(main, req->server_id, (unsigned int)req->cache_size);
+	} else if (req->type == REMOVE_SERVER) {
+		loader_remove_server(main, req->server_id);
+	} else {
+		request server_request = {
+			.type = req->type,
+			.doc_name = req->doc_name,
+		};
 
-	load_balancer *main = init_load_balancer(enable_vnodes);
+		if (req->type == EDIT_DOCUMENT) {
+			server_request.doc_content = req->doc_content;
+		}
 
-	for (int i = 0; i < requests_num; i++) {
-		request_type req_type =
-			read_request_arguments(input_file, buffer, &server_id, &cache_size,
-								   &doc_name, &doc_content);
-
-		if (req_type == ADD_SERVER) {
-			DIE(cache_size < 0, "cache size must be positive");
-			loader_add_server(main, server_id, (unsigned int)cache_size);
-		} else if (req_type == REMOVE_SERVER) {
-			loader_remove_server(main, server_id);
-		} else {
-			request server_request = {
-				.type = req_type,
-				.doc_name = doc_name,
-			};
+		/* with workers, the pool frees the request and writes the output */
+		if (main->workers) {
+			loader_forward_async(main, &server_request, owned);
+			return;
+		}
 
-			if (req_type == EDIT_DOCUMENT) {
-				server_request.doc_content = doc_content;
-			}
+		if (batch) {
+			batch->reqs[batch->size++] = server_request;
+			if (batch->size == batch->capacity)
+				flush_batch(main, batch, owned);
+			return;
+		}
 
-			response *response = loader_forward_request(main, &server_request);
+		response *response = loader_forward_request(main, &server_request);
 
+		if (owned) {
 			free(server_request.doc_name);
 			free(server_request.doc_content);
-
-			PRINT_RESPONSE(response);
 		}
+
+		sink_write_response(main->sink, response);
+		/* pending migrations advance between client requests */
+		loader_migrate_step(main);
 	}
+}
 
+/*
+ * In pipelined mode, requests are parsed on a parser thread and responses
+ * are formatted and written on the sink's output thread; this thread only
+ * routes requests through the load balancer. The stages are connected by
+ * bounded lock-free queues, so the output order is the serial one.
+ */
+void apply_requests(FILE *input_file, char *buffer, int requests_num,
+					run_options *opts) {
+	load_balancer *main = init_load_balancer(opts->enable_vnodes);
+	if (opts->enable_vnodes && opts->nr_replicas > 0)
+		main->nr_replicas = opts->nr_replicas;
+	main->coalesce_edits = opts->coalesce_edits;
+	loader_set_placement(main, opts->placement);
+	loader_set_cache_policy(main, opts->cache_policy);
+	if (opts->cache_bytes)
+		loader_set_cache_bytes(main);
+	if (opts->cache_budget)
+		loader_set_cache_budget(main, opts->cache_budget);
+	main->migrate_batch = opts->migrate_batch;
+	if (opts->lazy_migration)
+		loader_set_lazy_migration(main);
+	if (opts->load_factor > 0)
+		loader_set_bounded_load(main, opts->load_factor);
+	if (opts->hot_replicas > 0)
+		loader_set_hot_replicas(main, opts->hot_replicas);
+	if (opts->nr_copies > 1)
+		loader_set_replication(main, opts->nr_copies, opts->write_quorum,
+							   opts->read_quorum);
+	main->sink = init_response_sink(STDOUT_FILENO, opts->binary_output);
+	if (opts->nr_workers > 0)
+		main->workers = init_worker_pool(opts->nr_workers, main->sink);
+
+	mapped_input mapped;
+	request_parser parser = {
+		.input_file = input_file,
+		.buffer = buffer,
+		.mapped = NULL,
+		.requests_num = requests_num,
+		.parsed = NULL,
+	};
+	if (opts->mmap_input) {
+		map_input(input_file, &mapped);
+		parser.mapped = &mapped;
+	}
+
+	pthread_t parser_tid;
+	if (opts->pipeline) {
+		parser.parsed = spsc_create(PARSED_QUEUE_SIZE, sizeof(parsed_request));
+		DIE(pthread_create(&parser_tid, NULL, parser_thread, &parser) != 0,
+			"pthread_create failed");
+		/* with workers, the output is already formatted off this thread */
+		if (!main->workers)
+			sink_start_thread(main->sink);
+	}
+
+	request_batch batch = {0};
+	if (opts->batch_size > 0 && !main->workers) {
+		batch.capacity = opts->batch_size;
+		batch.reqs = malloc(batch.capacity * sizeof(request));
+		batch.resps = malloc(batch.capacity * sizeof(response *));
+		DIE(batch.reqs == NULL || batch.resps == NULL,
+			"Failed to allocate memory\n");
+	}
+
+	parsed_request req;
+	for (int i = 0; i < requests_num; i++) {
+		if (opts->pipeline)
+			spsc_pop(parser.parsed, &req);
+		else
+			parse_request(&parser, &req);
+
+		route_request(main, &req, !opts->mmap_input,
+					  batch.capacity ? &batch : NULL);
+	}
+	if (batch.size)
+		flush_batch(main, &batch, !opts->mmap_input);
+	free(batch.reqs);
+	free(batch.resps);
+
+	if (opts->pipeline) {
+		pthread_join(parser_tid, NULL);
+		spsc_free(parser.parsed);
+	}
+
+	if (main->workers)
+		worker_pool_wait_all(main->workers);
+	sink_flush(main->sink);
+	if (opts->print_stats)
+		loader_print_stats(main, stderr);
+
+	response_sink *sink = main->sink;
 	free_load_balancer(&main);
+	free_response_sink(&sink);
+	if (opts->mmap_input)
+		unmap_input(&mapped);
 }
 
 int main(int argc, char **argv) {
 	FILE *input;
 	int requests_num;
-	bool enable_vnodes;
+	run_options opts = {0};
 
 	char buffer[REQUEST_LENGTH + 1];
 
 	if (argc < 2) {
-		printf("Usage: %s <input_file>\n", argv[0]);
+		printf("Usage: %s <input_file> [--stats] [--coalesce-edits] "
+			   "[--mmap] [--binary-output] [--pipeline] [--workers=<n>] "
+			   "[--batch=<n>] [--migrate-batch=<n>] [--lazy-migration] "
+			   "[--placement=ring|jump|rendezvous|maglev] "
+			   "[--bounded-load=<c>] [--hot-replicas=<k>] "
+			   "[--replication=<n>] [--write-quorum=<w>] "
+			   "[--read-quorum=<r>] "
+			   "[--cache-policy=lru|clock|2q|arc|tinylfu] [--cache-bytes] "
+			   "[--cache-budget=<bytes>]\n",
+			   argv[0]);
 		return -1;
 	}
 
+	for (int i = 2; i < argc; i++) {
+		if (!strcmp(argv[i], "--stats")) {
+			opts.print_stats = true;
+		} else if (!strcmp(argv[i], "--coalesce-edits")) {
+			opts.coalesce_edits = true;
+		} else if (!strcmp(argv[i], "--mmap")) {
+			opts.mmap_input = true;
+		} else if (!strcmp(argv[i], "--binary-output")) {
+			opts.binary_output = true;
+		} else if (!strcmp(argv[i], "--pipeline")) {
+			opts.pipeline = true;
+		} else if (!strncmp(argv[i], "--workers=", strlen("--workers="))) {
+			opts.nr_workers = atoi(argv[i] + strlen("--workers="));
+			DIE(opts.nr_workers < 1 || opts.nr_workers > MAX_WORKERS,
+				"invalid number of workers");
+		} else if (!strncmp(argv[i], "--batch=", strlen("--batch="))) {
+			opts.batch_size = atoi(argv[i] + strlen("--batch="));
+			DIE(opts.batch_size < 1, "invalid batch size");
+		} else if (!strncmp(argv[i], "--migrate-batch=",
+							strlen("--migrate-batch="))) {
+			opts.migrate_batch = atoi(argv[i] + strlen("--migrate-batch="));
+			DIE(opts.migrate_batch < 1, "invalid migration batch size");
+		} else if (!strcmp(argv[i], "--lazy-migration")) {
+			opts.lazy_migration = true;
+		} else if (!strncmp(argv[i], "--placement=", strlen("--placement="))) {
+			int type = placement_parse(argv[i] + strlen("--placement="));
+			DIE(type < 0, "invalid placement");
+			opts.placement = type;
+		} else if (!strncmp(argv[i], "--cache-policy=",
+							strlen("--cache-policy="))) {
+			int policy = cache_policy_parse(argv[i] +
+											strlen("--cache-policy="));
+			DIE(policy < 0, "invalid cache policy");
+			opts.cache_policy = policy;
+		} else if (!strcmp(argv[i], "--cache-bytes")) {
+			opts.cache_bytes = true;
+		} else if (!strncmp(argv[i], "--cache-budget=",
+							strlen("--cache-budget="))) {
+			long long budget = atoll(argv[i] + strlen("--cache-budget="));
+			DIE(budget < 1, "invalid cache budget");
+			opts.cache_budget = budget;
+		} else if (!strncmp(argv[i], "--bounded-load=",
+							strlen("--bounded-load="))) {
+			opts.load_factor = atof(argv[i] + strlen("--bounded-load="));
+			DIE(opts.load_factor < 1, "invalid load factor");
+		} else if (!strncmp(argv[i], "--hot-replicas=",
+							strlen("--hot-replicas="))) {
+			opts.hot_replicas = atoi(argv[i] + strlen("--hot-replicas="));
+			DIE(opts.hot_replicas < 1 || opts.hot_replicas > MAX_HOT_REPLICAS,
+				"invalid number of hot replicas");
+		} else if (!strncmp(argv[i], "--replication=",
+							strlen("--replication="))) {
+			opts.nr_copies = atoi(argv[i] + strlen("--replication="));
+			DIE(opts.nr_copies < 1 || opts.nr_copies > MAX_COPIES,
+				"invalid replication factor");
+		} else if (!strncmp(argv[i], "--write-quorum=",
+							strlen("--write-quorum="))) {
+			opts.write_quorum = atoi(argv[i] + strlen("--write-quorum="));
+		} else if (!strncmp(argv[i], "--read-quorum=",
+							strlen("--read-quorum="))) {
+			opts.read_quorum = atoi(argv[i] + strlen("--read-quorum="));
+		} else {
+			printf("Unknown option: %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	/* workers would race with the migration steps run on this thread */
+	DIE((opts.migrate_batch || opts.lazy_migration) && opts.nr_workers,
+		"--migrate-batch cannot be used with --workers");
+	/* a pull may drain the old owner while a batch is being routed, which
+	 * would write its output ahead of the batch */
+	DIE(opts.lazy_migration && opts.batch_size,
+		"--lazy-migration cannot be used with --batch");
+	/* migrations follow arcs of the hash ring */
+	DIE((opts.migrate_batch || opts.lazy_migration) &&
+		opts.placement != PLACEMENT_RING,
+		"--migrate-batch needs --placement=ring");
+	/* spilled documents are placed by their successors on the ring, and
+	 * placing one may drain its owner while routing, which needs the
+	 * serial mode and documents that stay where they were created */
+	DIE(opts.load_factor > 0 && (opts.placement != PLACEMENT_RING ||
+		opts.nr_workers || opts.batch_size || opts.migrate_batch ||
+		opts.lazy_migration),
+		"--bounded-load needs --placement=ring, without workers, batches "
+		"or migrations");
+	/* a cache over the shared budget evicts documents of other servers,
+	 * which may be running on other workers */
+	DIE(opts.cache_budget && opts.nr_workers,
+		"--cache-budget cannot be used with --workers");
+	/* replica reads are answered while routing, in input order */
+	DIE(opts.hot_replicas && (opts.nr_workers || opts.batch_size),
+		"--hot-replicas cannot be used with --workers or --batch");
+	/* by default, writes wait for a majority and reads use every copy */
+	if (opts.nr_copies == 0)
+		opts.nr_copies = 1;
+	if (opts.write_quorum == 0)
+		opts.write_quorum = opts.nr_copies / 2 + 1;
+	if (opts.read_quorum == 0)
+		opts.read_quorum = opts.nr_copies;
+	DIE(opts.write_quorum < 1 || opts.write_quorum > opts.nr_copies ||
+		opts.read_quorum < 1 || opts.read_quorum > opts.nr_copies,
+		"quorums must be between 1 and the replication factor");
+	/* copies follow the ring; the other modes assume a single owner */
+	DIE(opts.nr_copies > 1 && (opts.placement != PLACEMENT_RING ||
+		opts.batch_size || opts.migrate_batch || opts.lazy_migration ||
+		opts.load_factor > 0 || opts.hot_replicas),
+		"--replication needs --placement=ring, without batches, "
+		"migrations, bounded load or hot replicas");
+
 	input = fopen(argv[1], "rt");
 	DIE(input == NULL, "missing input file");
 
 	DIE(fgets(buffer, REQUEST_LENGTH + 1, input) == 0, "empty input file");
 	requests_num = atoi(buffer);
-	enable_vnodes = strstr(buffer, "ENABLE_VNODES");
+	char *vnodes_opt = strstr(buffer, "ENABLE_VNODES");
+	opts.enable_vnodes = vnodes_opt;
+	/* "ENABLE_VNODES=<k>" sets the number of labels per server */
+	if (vnodes_opt && vnodes_opt[strlen("ENABLE_VNODES")] == '=') {
+		opts.nr_replicas = atoi(vnodes_opt + strlen("ENABLE_VNODES") + 1);
+		DIE(opts.nr_replicas < 1 || opts.nr_replicas > MAX_VNODES_REPLICAS,
+			"invalid number of vnodes");
+	}
 
-	apply_requests(input, buffer, requests_num, enable_vnodes);
+	apply_requests(input, buffer, requests_num, &opts);
 
 	fclose(input);
 
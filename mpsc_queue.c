@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "mpsc_queue.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+/* functia returneaza adresa celulei pentru indexul idx; numarul de
+ * secventa se afla la inceputul celulei, iar datele imediat dupa el
+*/
+static _Atomic size_t *mpsc_cell(mpsc_queue_t *q, size_t idx) {
+	return (_Atomic size_t *)(q->cells + (idx & q->mask) * q->cell_size);
+}
+
+mpsc_queue_t *mpsc_create(size_t capacity, size_t data_size) {
+	mpsc_queue_t *q = malloc(sizeof(mpsc_queue_t));
+	DIE(q == NULL, "Failed to allocate memory\n");
+
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	// celulele sunt aliniate la dimensiunea numarului de secventa
+	q->cell_size = (sizeof(size_t) + data_size + sizeof(size_t) - 1) &
+				   ~(sizeof(size_t) - 1);
+	q->cells = malloc(size * q->cell_size);
+	DIE(q->cells == NULL, "Failed to allocate memory\n");
+	q->mask = size - 1;
+	q->data_size = data_size;
+
+	// celula i este libera pentru producatorul care rezerva indexul i
+	for (size_t i = 0; i < size; i++)
+		atomic_init(mpsc_cell(q, i), i);
+	atomic_init(&q->write_idx, 0);
+	q->read_idx = 0;
+	atomic_init(&q->sleeping, false);
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond, NULL);
+	return q;
+}
+
+bool mpsc_try_push(mpsc_queue_t *q, const void *data) {
+	size_t idx = atomic_load_explicit(&q->write_idx, memory_order_relaxed);
+	_Atomic size_t *cell;
+
+	while (1) {
+		cell = mpsc_cell(q, idx);
+		size_t seq = atomic_load_explicit(cell, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)idx;
+		if (diff == 0) {
+			// celula este libera; se rezerva daca nu a luat-o alt producator
+			if (atomic_compare_exchange_weak_explicit(&q->write_idx, &idx,
+													  idx + 1,
+													  memory_order_relaxed,
+													  memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			// celula inca nu a fost citita de consumator: coada este plina
+			return false;
+		} else {
+			// alt producator a rezervat deja indexul
+			idx = atomic_load_explicit(&q->write_idx, memory_order_relaxed);
+		}
+	}
+
+	memcpy((char *)cell + sizeof(size_t), data, q->data_size);
+	atomic_store_explicit(cell, idx + 1, memory_order_release);
+
+	// elementul publicat este vazut de consumator inainte ca acesta sa
+	// adoarma, sau producatorul vede ca el doarme si il trezeste
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&q->sleeping, memory_order_relaxed)) {
+		pthread_mutex_lock(&q->lock);
+		pthread_cond_signal(&q->cond);
+		pthread_mutex_unlock(&q->lock);
+	}
+	return true;
+}
+
+void mpsc_push(mpsc_queue_t *q, const void *data) {
+	for (unsigned int tries = 0; !mpsc_try_push(q, data); tries++)
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+}
+
+size_t mpsc_pop_batch(mpsc_queue_t *q, void *data, size_t max) {
+	size_t count = 0;
+
+	while (count < max) {
+		_Atomic size_t *cell = mpsc_cell(q, q->read_idx);
+		size_t seq = atomic_load_explicit(cell, memory_order_acquire);
+		if (seq != q->read_idx + 1)
+			break;
+
+		memcpy((char *)data + count * q->data_size,
+			   (char *)cell + sizeof(size_t), q->data_size);
+		// celula devine libera pentru tura urmatoare a producatorilor
+		atomic_store_explicit(cell, q->read_idx + q->mask + 1,
+							  memory_order_release);
+		q->read_idx++;
+		count++;
+	}
+	return count;
+}
+
+/* functia verifica, fara a scoate nimic, daca primul element este gata
+*/
+static bool mpsc_is_empty(mpsc_queue_t *q) {
+	size_t seq = atomic_load_explicit(mpsc_cell(q, q->read_idx),
+									  memory_order_acquire);
+	return seq != q->read_idx + 1;
+}
+
+size_t mpsc_wait_batch(mpsc_queue_t *q, void *data, size_t max) {
+	size_t count;
+
+	for (unsigned int tries = 0; tries < SPSC_SPIN_LIMIT + MPSC_YIELD_LIMIT;
+		 tries++) {
+		count = mpsc_pop_batch(q, data, max);
+		if (count)
+			return count;
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+	}
+
+	// consumatorul anunta ca doarme si verifica din nou coada inainte de a
+	// adormi, sub lock, ca trezirea unui producator sa nu se piarda
+	pthread_mutex_lock(&q->lock);
+	atomic_store_explicit(&q->sleeping, true, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	while (mpsc_is_empty(q))
+		pthread_cond_wait(&q->cond, &q->lock);
+	atomic_store_explicit(&q->sleeping, false, memory_order_relaxed);
+	pthread_mutex_unlock(&q->lock);
+
+	return mpsc_pop_batch(q, data, max);
+}
+
+void mpsc_free(mpsc_queue_t *q) {
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->cond);
+	free(q->cells);
+	free(q);
+}
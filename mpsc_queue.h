@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "spsc_queue.h"
+
+// numarul de cedari ale procesorului dupa care consumatorul adoarme
+#define MPSC_YIELD_LIMIT 16
+
+/* coada circulara marginita, fara lock-uri, pentru mai multi producatori si
+ * un singur consumator; fiecare celula are un numar de secventa care arata
+ * daca este libera pentru tura curenta a producatorilor sau plina pentru
+ * consumator, iar datele elementului urmeaza dupa el
+ * producatorii isi rezerva o celula incrementand write_idx cu CAS
+*/
+typedef struct mpsc_queue_t {
+	// indexul urmatoarei celule rezervate de un producator
+	_Atomic size_t write_idx;
+	char pad_write[CACHE_LINE_SIZE - sizeof(size_t)];
+	// indexul urmatoarei celule citite, folosit doar de consumator
+	size_t read_idx;
+	char pad_read[CACHE_LINE_SIZE - sizeof(size_t)];
+	// consumatorul adormit este trezit de producatori prin cond
+	_Atomic bool sleeping;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	// capacitatea este o putere a lui 2
+	size_t mask;
+	size_t data_size;
+	size_t cell_size;
+	char *cells;
+} mpsc_queue_t;
+
+/**
+ * mpsc_create() - Creates a bounded multi-producer single-consumer queue.
+ *
+ * @param capacity: Minimum number of elements; rounded up to a power of 2.
+ * @param data_size: Size of an element, copied in and out of the queue.
+ */
+mpsc_queue_t *mpsc_create(size_t capacity, size_t data_size);
+
+/**
+ * mpsc_try_push() - Copies data at the back of the queue and wakes the
+ *      consumer if it sleeps. Safe to call from any number of threads.
+ *
+ * @return bool: false if the queue is full.
+ */
+bool mpsc_try_push(mpsc_queue_t *q, const void *data);
+
+/**
+ * mpsc_push() - Like mpsc_try_push(), but waits while the queue is full,
+ *      spinning first and then yielding the processor.
+ */
+void mpsc_push(mpsc_queue_t *q, const void *data);
+
+/**
+ * mpsc_pop_batch() - Moves up to max elements from the front of the queue
+ *      to data, in order, without waiting. Must only be called from the
+ *      consumer thread.
+ *
+ * @return size_t: Number of elements moved.
+ */
+size_t mpsc_pop_batch(mpsc_queue_t *q, void *data, size_t max);
+
+/**
+ * mpsc_wait_batch() - Like mpsc_pop_batch(), but waits until at least one
+ *      element is available: it spins, then yields the processor, and
+ *      finally sleeps until a producer wakes it.
+ */
+size_t mpsc_wait_batch(mpsc_queue_t *q, void *data, size_t max);
+
+void mpsc_free(mpsc_queue_t *q);
+
+#endif /* MPSC_QUEUE_H */
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "placement.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+// scorurile rendezvous a HRW_LANES servere, calculate cu aceleasi
+// instructiuni
+typedef unsigned int hrw_vec
+	__attribute__((vector_size(HRW_LANES * sizeof(unsigned int))));
+
+static const char *placement_names[PLACEMENT_TYPES] = {
+	"ring", "jump", "rendezvous", "maglev",
+};
+
+int placement_parse(const char *name) {
+	for (int i = 0; i < PLACEMENT_TYPES; i++)
+		if (!strcmp(name, placement_names[i]))
+			return i;
+	return -1;
+}
+
+const char *placement_name(placement_type type) {
+	return placement_names[type];
+}
+
+/* functie care verifica daca un numar este prim
+*/
+static bool is_prime(unsigned int n) {
+	if (n < 2)
+		return false;
+	for (unsigned int d = 2; d * d <= n; d++)
+		if (n % d == 0)
+			return false;
+	return true;
+}
+
+/* functie care returneaza cel mai mic numar prim mai mare sau egal cu n
+*/
+static unsigned int next_prime(unsigned int n) {
+	while (!is_prime(n))
+		n++;
+	return n;
+}
+
+placement *init_placement(placement_type type) {
+	placement *p = calloc(1, sizeof(placement));
+	DIE(p == NULL, "Failed to allocate memory\n");
+	p->type = type;
+	p->added_slot = -1;
+
+	if (type == PLACEMENT_MAGLEV) {
+		p->table_size = MAGLEV_MIN_TABLE_SIZE;
+		p->table = malloc(p->table_size * sizeof(int));
+		p->old_table = malloc(p->table_size * sizeof(int));
+		DIE(p->table == NULL || p->old_table == NULL,
+			"Failed to allocate memory\n");
+		for (unsigned int i = 0; i < p->table_size; i++)
+			p->table[i] = -1;
+	}
+	return p;
+}
+
+/* functie care face loc pentru inca un membru, dubland capacitatea
+ * vectorilor paraleli, si pentru indexul slotului sau
+*/
+static void reserve_member(placement *p, int slot) {
+	if (p->nr_members == p->members_cap) {
+		int cap = p->members_cap ? 2 * p->members_cap : 2 * HRW_LANES;
+		p->slots = realloc(p->slots, cap * sizeof(int));
+		p->seeds = realloc(p->seeds, cap * sizeof(unsigned int));
+		p->changed = realloc(p->changed, (cap + 1) * sizeof(int));
+		DIE(p->slots == NULL || p->seeds == NULL || p->changed == NULL,
+			"Failed to allocate memory\n");
+		p->members_cap = cap;
+	}
+
+	if (slot >= p->member_of_cap) {
+		int cap = p->member_of_cap ? p->member_of_cap : HRW_LANES;
+		while (cap <= slot)
+			cap *= 2;
+		p->member_of = realloc(p->member_of, cap * sizeof(int));
+		DIE(p->member_of == NULL, "Failed to allocate memory\n");
+		for (int i = p->member_of_cap; i < cap; i++)
+			p->member_of[i] = -1;
+		p->member_of_cap = cap;
+	}
+}
+
+/* functie care returneaza bucketul unui document cu jump consistent hash:
+ * cheia sare prin bucketuri cu un generator liniar congruential, iar
+ * ultimul bucket atins sub nr_buckets este cel al documentului
+*/
+static int jump_bucket(unsigned int hash, int nr_buckets) {
+	uint64_t key = hash_uint(&hash);
+	int64_t bucket = -1, next = 0;
+	while (next < nr_buckets) {
+		bucket = next;
+		key = key * 2862933555777941757ULL + 1;
+		next = (bucket + 1) * ((double)(1LL << 31) /
+							   (double)((key >> 33) + 1));
+	}
+	return bucket;
+}
+
+/* functie care calculeaza scorul rendezvous al unui server pentru un
+ * document; functia de amestecare este bijectiva, deci doua servere nu au
+ * niciodata acelasi scor
+*/
+static unsigned int hrw_score(unsigned int hash, unsigned int seed) {
+	unsigned int x = hash ^ seed;
+	x = ((x >> 16u) ^ x) * 0x45d9f3b;
+	x = ((x >> 16u) ^ x) * 0x45d9f3b;
+	return (x >> 16u) ^ x;
+}
+
+/* functie care gaseste serverul cu scorul rendezvous maxim; scorurile
+ * sunt calculate cate HRW_LANES o data, iar fiecare lane retine maximul
+ * scorurilor sale si indexul lui; ultimii membri, care nu umplu un vector,
+ * sunt verificati la final
+*/
+static int hrw_locate(placement *p, unsigned int hash) {
+	hrw_vec h = (hrw_vec){0} + hash;
+	hrw_vec best = {0}, best_idx = {0}, idx;
+	for (int lane = 0; lane < HRW_LANES; lane++)
+		idx[lane] = lane;
+	int n = p->nr_members - p->nr_members % HRW_LANES;
+	for (int i = 0; i < n; i += HRW_LANES) {
+		hrw_vec x;
+		memcpy(&x, p->seeds + i, sizeof(x));
+		x ^= h;
+		x = ((x >> 16u) ^ x) * 0x45d9f3b;
+		x = ((x >> 16u) ^ x) * 0x45d9f3b;
+		x = (x >> 16u) ^ x;
+		// lane-urile in care scorul nou este mai mare preiau scorul si
+		// indexul; primul vector este luat in intregime
+		hrw_vec greater = (hrw_vec)(x > best) | ((hrw_vec){0} - (i == 0));
+		best = (x & greater) | (best & ~greater);
+		best_idx = (idx & greater) | (best_idx & ~greater);
+		idx += HRW_LANES;
+	}
+
+	int winner = -1;
+	unsigned int max = 0;
+	for (int lane = 0; lane < HRW_LANES && n > 0; lane++) {
+		if (winner < 0 || best[lane] > max) {
+			max = best[lane];
+			winner = best_idx[lane];
+		}
+	}
+	for (int i = n; i < p->nr_members; i++) {
+		unsigned int score = hrw_score(hash, p->seeds[i]);
+		if (winner < 0 || score > max) {
+			max = score;
+			winner = i;
+		}
+	}
+	return p->slots[winner];
+}
+
+/* un membru, asa cum este folosit la construirea tabelei Maglev
+*/
+typedef struct maglev_member {
+	unsigned int seed;
+	int slot;
+} maglev_member;
+
+static int compare_maglev_members(const void *a, const void *b) {
+	unsigned int x = ((const maglev_member *)a)->seed;
+	unsigned int y = ((const maglev_member *)b)->seed;
+	return (x > y) - (x < y);
+}
+
+/* functie care umple tabela Maglev: fiecare server are o permutare a
+ * intrarilor (offset si pas derivate din seed), iar serverele isi iau pe
+ * rand urmatoarea intrare libera din permutarea lor
+ * serverele sunt luate in ordinea seedurilor, deci tabela depinde doar de
+ * multimea serverelor, nu si de ordinea in care au fost adaugate
+*/
+static void maglev_populate(placement *p) {
+	unsigned int size = p->table_size;
+	for (unsigned int i = 0; i < size; i++)
+		p->table[i] = -1;
+	int n = p->nr_members;
+	if (n == 0)
+		return;
+
+	maglev_member *members = malloc(n * sizeof(maglev_member));
+	unsigned int *pos = malloc(n * sizeof(unsigned int));
+	unsigned int *skip = malloc(n * sizeof(unsigned int));
+	DIE(members == NULL || pos == NULL || skip == NULL,
+		"Failed to allocate memory\n");
+	for (int i = 0; i < n; i++) {
+		members[i].seed = p->seeds[i];
+		members[i].slot = p->slots[i];
+	}
+	qsort(members, n, sizeof(maglev_member), compare_maglev_members);
+	for (int i = 0; i < n; i++) {
+		pos[i] = members[i].seed % size;
+		skip[i] = hash_uint(&members[i].seed) % (size - 1) + 1;
+	}
+
+	// dimensiunea este prima, deci fiecare permutare trece prin toate
+	// intrarile, iar tabela se umple
+	unsigned int filled = 0;
+	while (filled < size) {
+		for (int i = 0; i < n && filled < size; i++) {
+			while (p->table[pos[i]] >= 0)
+				pos[i] = (pos[i] + skip[i]) % size;
+			p->table[pos[i]] = members[i].slot;
+			pos[i] = (pos[i] + skip[i]) % size;
+			filled++;
+		}
+	}
+
+	free(members);
+	free(pos);
+	free(skip);
+}
+
+/* functie care reconstruieste tabela Maglev dupa o schimbare de servere si
+ * adauga la changed vechii proprietari ai intrarilor care si-au schimbat
+ * proprietarul; tabela creste cand fiecare server ar avea mai putin de
+ * MAGLEV_ENTRIES_PER_SERVER intrari, caz in care toate serverele pot
+ * pierde documente
+*/
+static void maglev_rebuild(placement *p) {
+	unsigned int size = p->table_size;
+	while ((unsigned long)p->nr_members * MAGLEV_ENTRIES_PER_SERVER > size)
+		size = next_prime(2 * size);
+
+	int *aux = p->old_table;
+	p->old_table = p->table;
+	p->table = aux;
+	if (size != p->table_size) {
+		p->table_size = size;
+		p->table = realloc(p->table, size * sizeof(int));
+		p->old_table = realloc(p->old_table, size * sizeof(int));
+		DIE(p->table == NULL || p->old_table == NULL,
+			"Failed to allocate memory\n");
+		maglev_populate(p);
+		for (int i = 0; i < p->nr_members; i++)
+			if (p->slots[i] != p->added_slot)
+				p->changed[p->nr_changed++] = p->slots[i];
+		return;
+	}
+	maglev_populate(p);
+
+	// fiecare slot este adaugat o singura data
+	char *seen = calloc(p->member_of_cap, sizeof(char));
+	DIE(seen == NULL, "Failed to allocate memory\n");
+	for (int i = 0; i < p->nr_changed; i++)
+		seen[p->changed[i]] = 1;
+	for (unsigned int i = 0; i < size; i++) {
+		int owner = p->old_table[i];
+		if (owner >= 0 && owner != p->table[i] && !seen[owner]) {
+			seen[owner] = 1;
+			p->changed[p->nr_changed++] = owner;
+		}
+	}
+	free(seen);
+}
+
+void placement_add_server(placement *p, int slot, int server_id) {
+	reserve_member(p, slot);
+	int n = p->nr_members++;
+	p->slots[n] = slot;
+	p->seeds[n] = hash_uint(&server_id);
+	p->member_of[slot] = n;
+	p->added_slot = slot;
+
+	// cu jump si rendezvous, orice server poate ceda documente noului
+	// server; cu Maglev, doar cele care au pierdut intrari din tabela
+	p->nr_changed = 0;
+	if (p->type == PLACEMENT_MAGLEV) {
+		maglev_rebuild(p);
+		return;
+	}
+	for (int i = 0; i < n; i++)
+		p->changed[p->nr_changed++] = p->slots[i];
+}
+
+void placement_remove_server(placement *p, int slot) {
+	int i = p->member_of[slot];
+	if (i < 0)
+		return;
+	int last = --p->nr_members;
+	p->member_of[slot] = -1;
+	p->added_slot = -1;
+	p->nr_changed = 0;
+	p->changed[p->nr_changed++] = slot;
+
+	// ultimul membru ia locul celui eliminat; la jump, el preia bucketul
+	// acestuia, iar documentele din ultimul bucket sunt redistribuite
+	if (i != last) {
+		p->slots[i] = p->slots[last];
+		p->seeds[i] = p->seeds[last];
+		p->member_of[p->slots[i]] = i;
+		if (p->type == PLACEMENT_JUMP)
+			p->changed[p->nr_changed++] = p->slots[i];
+	}
+
+	if (p->type == PLACEMENT_MAGLEV)
+		maglev_rebuild(p);
+}
+
+int placement_locate(placement *p, unsigned int hash) {
+	if (p->nr_members == 0)
+		return -1;
+
+	switch (p->type) {
+	case PLACEMENT_JUMP:
+		return p->slots[jump_bucket(hash, p->nr_members)];
+	case PLACEMENT_RENDEZVOUS:
+		return hrw_locate(p, hash);
+	case PLACEMENT_MAGLEV:
+		return p->table[hash_uint(&hash) % p->table_size];
+	default:
+		return -1;
+	}
+}
+
+int placement_relocate(placement *p, unsigned int hash, int slot) {
+	// dupa adaugarea unui server, documentul ramane pe slot sau trece pe
+	// noul server, dupa scorul mai mare
+	if (p->type == PLACEMENT_RENDEZVOUS && p->added_slot >= 0 &&
+		p->member_of[slot] >= 0) {
+		unsigned int added = p->seeds[p->member_of[p->added_slot]];
+		unsigned int current = p->seeds[p->member_of[slot]];
+		return hrw_score(hash, added) > hrw_score(hash, current) ?
+			   p->added_slot : slot;
+	}
+	return placement_locate(p, hash);
+}
+
+void free_placement(placement **p) {
+	free((*p)->slots);
+	free((*p)->seeds);
+	free((*p)->member_of);
+	free((*p)->changed);
+	free((*p)->table);
+	free((*p)->old_table);
+	free(*p);
+	*p = NULL;
+}
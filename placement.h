@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stdbool.h>
+
+// numarul de scoruri rendezvous calculate deodata, intr-un vector SIMD
+#define HRW_LANES 4
+// dimensiunea initiala a tabelei Maglev, un numar prim
+#define MAGLEV_MIN_TABLE_SIZE 65537
+// numarul minim de intrari din tabela Maglev pentru fiecare server
+#define MAGLEV_ENTRIES_PER_SERVER 100
+
+typedef enum placement_type {
+	// hash ring-ul cu etichete al load balancer-ului
+	PLACEMENT_RING,
+	// jump consistent hash: serverele sunt bucketuri numerotate
+	PLACEMENT_JUMP,
+	// rendezvous (HRW): documentul apartine serverului cu scorul maxim
+	PLACEMENT_RENDEZVOUS,
+	// Maglev: o tabela de dimensiune prima, impartita intre servere
+	PLACEMENT_MAGLEV,
+	PLACEMENT_TYPES,
+} placement_type;
+
+/* plasarea documentelor pentru strategiile care nu folosesc hash ring-ul
+ * membrii sunt serverele existente, retinute prin slotul lor din load
+ * balancer si printr-un seed derivat din id
+*/
+typedef struct placement {
+	placement_type type;
+	// sloturile si seedurile membrilor, in vectori paraleli; la jump,
+	// membrul i este bucketul i
+	int *slots;
+	unsigned int *seeds;
+	int nr_members;
+	int members_cap;
+	// indexul membrului din fiecare slot, -1 pentru sloturile fara server
+	int *member_of;
+	int member_of_cap;
+	// tabela Maglev (slotul care detine fiecare intrare) si tabela
+	// dinaintea ultimei schimbari
+	int *table;
+	int *old_table;
+	unsigned int table_size;
+	// slotul adaugat la ultima schimbare, -1 daca aceasta a fost o eliminare
+	int added_slot;
+	// sloturile serverelor care pot pierde documente la ultima schimbare
+	int *changed;
+	int nr_changed;
+} placement;
+
+/**
+ * placement_parse() - Returns the placement type called name ("ring",
+ *      "jump", "rendezvous" or "maglev"), or -1 if there is none.
+ */
+int placement_parse(const char *name);
+
+const char *placement_name(placement_type type);
+
+/**
+ * init_placement() - Creates an empty placement of the given type. The
+ *      ring has no placement; it is kept by the load balancer itself.
+ */
+placement *init_placement(placement_type type);
+
+/**
+ * placement_add_server() - Adds the server in slot as a member. Afterwards
+ *      changed lists the slots whose documents may now belong to it.
+ */
+void placement_add_server(placement *p, int slot, int server_id);
+
+/**
+ * placement_remove_server() - Removes the server in slot. Afterwards
+ *      changed lists the slots whose documents may have a new owner,
+ *      including the removed slot itself.
+ */
+void placement_remove_server(placement *p, int slot);
+
+/**
+ * placement_locate() - Returns the slot of the server owning a document.
+ *
+ * @param hash: Hash of the document name, as kept in doc_t.
+ * @return int: Slot of the owner, or -1 if there are no servers.
+ */
+int placement_locate(placement *p, unsigned int hash);
+
+/**
+ * placement_relocate() - Like placement_locate(), for a document owned by
+ *      slot before the last change. With rendezvous, after an add, only
+ *      the score of the added server is computed.
+ */
+int placement_relocate(placement *p, unsigned int hash, int slot);
+
+void free_placement(placement **p);
+
+#endif /* PLACEMENT_H */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2024, Andrei Otetea <andreiotetea23@gmail.com>
+ * Copyright (c) 2024, Eduard Marin <marin.eduard.c@gmail.com>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "request_parser.h"
+#include "utils.h"
+
+static void read_quoted_string(char *buffer, int buffer_len, int *start, int *end) {
+	*end = -1;
+
+	for (int i = 0; i < buffer_len && buffer[i] != '\0'; ++i) {
+		if (buffer[i] != '"') continue;
+
+		if (*start == -1) {
+			*start = i;
+		} else {
+			*end = i;
+			break;
+		}
+	}
+}
+
+request_type read_request_arguments(FILE *input_file, char *buffer,
+									int *maybe_server_id, int *maybe_cache_size,
+									char **maybe_doc_name,
+									char **maybe_doc_content) {
+	request_type req_type;
+	int word_start = -1;
+	int word_end = -1;
+
+	DIE(fgets(buffer, REQUEST_LENGTH + 1, input_file) == NULL,
+		"insufficient requests");
+
+	req_type = get_request_type(buffer);
+
+	if (req_type == ADD_SERVER) {
+		*maybe_server_id = atoi(buffer + strlen(ADD_SERVER_REQUEST) + 1);
+		*maybe_cache_size =
+			atoi(strchr(buffer + strlen(ADD_SERVER_REQUEST) + 1, ' '));
+	} else if (req_type == REMOVE_SERVER) {
+		*maybe_server_id = atoi(buffer + strlen(REMOVE_SERVER_REQUEST) + 1);
+	} else {
+		*maybe_doc_name = calloc(1, DOC_NAME_LENGTH + 1);
+		DIE(*maybe_doc_name == NULL, "calloc failed");
+
+		read_quoted_string(buffer, REQUEST_LENGTH, &word_start, &word_end);
+		memcpy(*maybe_doc_name, buffer + word_start + 1,
+			   word_end - word_start - 1);
+
+		if (req_type == EDIT_DOCUMENT) {
+			char *tmp_buffer = buffer + word_end + 1;
+
+			*maybe_doc_content = calloc(1, DOC_CONTENT_LENGTH + 1);
+			DIE(*maybe_doc_content == NULL, "calloc failed");
+
+			/* Read the content, which might be a multiline quoted string */
+			word_start = -1;
+			read_quoted_string(tmp_buffer, DOC_CONTENT_LENGTH, &word_start,
+							   &word_end);
+
+			if (word_end == -1)
+				strcpy(*maybe_doc_content, tmp_buffer + word_start + 1);
+			else
+				strncpy(*maybe_doc_content, tmp_buffer + word_start + 1,
+						word_end - word_start - 1);
+
+			while (word_end == -1) {
+				DIE(fgets(buffer, DOC_CONTENT_LENGTH + 1, input_file) == NULL,
+					"document content is not properly quoted");
+
+				read_quoted_string(buffer, DOC_CONTENT_LENGTH, &word_start,
+								   &word_end);
+				memcpy(*maybe_doc_content + strlen(*maybe_doc_content), buffer,
+					   word_end == -1 ? strlen(buffer) : (unsigned)word_end);
+			}
+		} else {
+			*maybe_doc_content = NULL;
+		}
+	}
+
+	return req_type;
+}
+
+void map_input(FILE *input_file, mapped_input *in) {
+	struct stat st;
+	DIE(fstat(fileno(input_file), &st) < 0, "fstat failed");
+
+	in->size = st.st_size;
+	in->pos = ftell(input_file);
+	in->data = mmap(NULL, in->size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+					fileno(input_file), 0);
+	DIE(in->data == MAP_FAILED, "mmap failed");
+	madvise(in->data, in->size, MADV_SEQUENTIAL);
+}
+
+void unmap_input(mapped_input *in) {
+	munmap(in->data, in->size);
+}
+
+static int parse_int(char *p, char *end, char **next) {
+	int sign = 1, value = 0;
+
+	while (p < end && *p == ' ')
+		p++;
+	if (p < end && (*p == '-' || *p == '+'))
+		sign = *p++ == '-' ? -1 : 1;
+	while (p < end && *p >= '0' && *p <= '9')
+		value = value * 10 + (*p++ - '0');
+
+	*next = p;
+	return sign * value;
+}
+
+request_type map_request_arguments(mapped_input *in, int *maybe_server_id,
+								   int *maybe_cache_size,
+								   char **maybe_doc_name,
+								   char **maybe_doc_content) {
+	request_type req_type;
+	char *line = in->data + in->pos;
+	char *end = in->data + in->size;
+
+	DIE(line >= end, "insufficient requests");
+
+	char *eol = memchr(line, '\n', end - line);
+	if (eol == NULL)
+		eol = end;
+
+	req_type = get_request_type(line);
+
+	if (req_type == ADD_SERVER) {
+		char *p = line + strlen(ADD_SERVER_REQUEST);
+		*maybe_server_id = parse_int(p, eol, &p);
+		*maybe_cache_size = parse_int(p, eol, &p);
+	} else if (req_type == REMOVE_SERVER) {
+		char *p = line + strlen(REMOVE_SERVER_REQUEST);
+		*maybe_server_id = parse_int(p, eol, &p);
+	} else {
+		char *name_start = memchr(line, '"', eol - line);
+		DIE(name_start == NULL, "document name is not properly quoted");
+		char *name_end = memchr(name_start + 1, '"', eol - name_start - 1);
+		DIE(name_end == NULL, "document name is not properly quoted");
+
+		*name_end = '\0';
+		*maybe_doc_name = name_start + 1;
+		*maybe_doc_content = NULL;
+
+		if (req_type == EDIT_DOCUMENT) {
+			/* The content might be a multiline quoted string */
+			char *content_start = memchr(name_end + 1, '"',
+										 end - name_end - 1);
+			DIE(content_start == NULL, "document content is not quoted");
+			char *content_end = memchr(content_start + 1, '"',
+									   end - content_start - 1);
+			DIE(content_end == NULL,
+				"document content is not properly quoted");
+
+			*content_end = '\0';
+			*maybe_doc_content = content_start + 1;
+
+			if (content_end > eol) {
+				eol = memchr(content_end + 1, '\n', end - content_end - 1);
+				if (eol == NULL)
+					eol = end;
+			}
+		}
+	}
+
+	in->pos = eol < end ? (size_t)(eol - in->data) + 1 : in->size;
+	return req_type;
+}
+
+void parse_request(request_parser *parser, parsed_request *req) {
+	if (parser->mapped)
+		req->type = map_request_arguments(parser->mapped, &req->server_id,
+										  &req->cache_size, &req->doc_name,
+										  &req->doc_content);
+	else
+		req->type = read_request_arguments(parser->input_file, parser->buffer,
+										   &req->server_id, &req->cache_size,
+										   &req->doc_name, &req->doc_content);
+}
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024, Andrei Otetea <andreiotetea23@gmail.com>
+ * Copyright (c) 2024, Eduard Marin <marin.eduard.c@gmail.com>
+ */
+
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+#include <stdio.h>
+
+#include "constants.h"
+#include "spsc_queue.h"
+
+/*
+ * Requests read straight from a private mapping of the input file. Names
+ * and contents are handed out as slices of the mapping, NUL-terminated in
+ * place over their closing quote, so nothing is copied or allocated per
+ * request.
+ */
+typedef struct mapped_input {
+	char *data;
+	size_t size;
+	size_t pos;
+} mapped_input;
+
+/* A parsed request, as handed from the parser to the routing stage */
+typedef struct parsed_request {
+	request_type type;
+	int server_id;
+	int cache_size;
+	char *doc_name;
+	char *doc_content;
+} parsed_request;
+
+typedef struct request_parser {
+	FILE *input_file;
+	char *buffer;
+	/* NULL unless the input is read through mmap */
+	mapped_input *mapped;
+	int requests_num;
+	/* filled by the parser thread in pipelined mode */
+	spsc_queue_t *parsed;
+} request_parser;
+
+/**
+ * read_request_arguments() - Reads the next request with fgets into buffer.
+ *      The document name and content are allocated here and owned by the
+ *      caller.
+ */
+request_type read_request_arguments(FILE *input_file, char *buffer,
+									int *maybe_server_id, int *maybe_cache_size,
+									char **maybe_doc_name,
+									char **maybe_doc_content);
+
+/**
+ * map_input() - Maps input_file privately, from its current position on.
+ */
+void map_input(FILE *input_file, mapped_input *in);
+
+/**
+ * unmap_input() - Unmaps an input mapped by map_input().
+ */
+void unmap_input(mapped_input *in);
+
+/**
+ * map_request_arguments() - Reads the next request from the mapping. The
+ *      document name and content point into the mapping and must not be
+ *      freed.
+ */
+request_type map_request_arguments(mapped_input *in, int *maybe_server_id,
+								   int *maybe_cache_size,
+								   char **maybe_doc_name,
+								   char **maybe_doc_content);
+
+/**
+ * parse_request() - Reads the next request, from the mapping if there is
+ *      one, otherwise with fgets.
+ */
+void parse_request(request_parser *parser, parsed_request *req);
+
+#endif /* REQUEST_PARSER_H */
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "response_sink.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+/* functie care creeaza un sink pentru raspunsuri, cu un buffer de
+ * SINK_BUFFER_SIZE octeti; bufferul unui sink care doar captureaza outputul
+ * este alocat la prima scriere
+*/
+response_sink *init_response_sink(int fd, bool binary) {
+	response_sink *sink = malloc(sizeof(response_sink));
+	DIE(sink == NULL, "Failed to allocate memory\n");
+	sink->buff = NULL;
+	sink->capacity = 0;
+	if (fd != SINK_CAPTURE_FD) {
+		sink->buff = malloc(SINK_BUFFER_SIZE);
+		DIE(sink->buff == NULL, "Failed to allocate memory\n");
+		sink->capacity = SINK_BUFFER_SIZE;
+	}
+
+	sink->fd = fd;
+	sink->binary = binary;
+	sink->size = 0;
+	sink->free_responses = NULL;
+	sink->nr_writes = 0;
+	sink->threaded = false;
+	sink->pending = NULL;
+	sink->recycled = NULL;
+	return sink;
+}
+
+/* functie care returneaza un raspuns gol, luat din lista de raspunsuri
+ * refolosibile daca aceasta nu este goala
+*/
+response *sink_new_response(response_sink *sink, int server_id) {
+	response *resp = NULL;
+	// raspunsurile scrise de thread-ul de output se intorc prin recycled
+	if (!sink->threaded || !spsc_try_pop(sink->recycled, &resp)) {
+		resp = sink->free_responses;
+		if (resp)
+			sink->free_responses = resp->next;
+	}
+	if (resp == NULL) {
+		resp = calloc(1, sizeof(response));
+		DIE(resp == NULL, "Failed to allocate memory\n");
+	}
+
+	resp->server_id = server_id;
+	resp->server_log = NULL;
+	resp->server_response = NULL;
+	resp->next = NULL;
+	return resp;
+}
+
+/* functie care formateaza un camp al raspunsului in bufferul sau,
+ * marind bufferul doar daca rezultatul nu incape
+*/
+static char *format_into(char **buff, size_t *cap, size_t max_len,
+						 const char *format, va_list args) {
+	va_list copy;
+	va_copy(copy, args);
+	int len = vsnprintf(*buff, *cap, format, copy);
+	va_end(copy);
+	DIE(len < 0, "vsnprintf failed");
+
+	if ((size_t)len >= *cap && *cap < max_len) {
+		// bufferul este prea mic; se mareste la dimensiunea necesara
+		*cap = (size_t)len + 1 < max_len ? (size_t)len + 1 : max_len;
+		*buff = realloc(*buff, *cap);
+		DIE(*buff == NULL, "Failed to allocate memory\n");
+		vsnprintf(*buff, *cap, format, args);
+	}
+	return *buff;
+}
+
+void response_set_log(response *resp, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	resp->server_log = format_into(&resp->log_buff, &resp->log_cap,
+								   MAX_LOG_LENGTH, format, args);
+	va_end(args);
+}
+
+void response_set_response(response *resp, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	resp->server_response = format_into(&resp->response_buff,
+										&resp->response_cap,
+										MAX_RESPONSE_LENGTH, format, args);
+	va_end(args);
+}
+
+void sink_recycle_response(response_sink *sink, response *resp) {
+	resp->next = sink->free_responses;
+	sink->free_responses = resp;
+}
+
+/* functie care scrie tot continutul bufferului, reluand write-ul daca
+ * acesta scrie doar o parte
+*/
+static void sink_write_buffer(response_sink *sink) {
+	if (sink->fd == SINK_CAPTURE_FD)
+		return;
+
+	size_t written = 0;
+	while (written < sink->size) {
+		ssize_t ret = write(sink->fd, sink->buff + written,
+							sink->size - written);
+		DIE(ret < 0, "write failed");
+		written += ret;
+		sink->nr_writes++;
+	}
+	sink->size = 0;
+}
+
+/* functie care face loc in buffer pentru inca len octeti: un sink care
+ * captureaza outputul isi mareste bufferul, iar celelalte il scriu
+*/
+static void sink_reserve(response_sink *sink, size_t len) {
+	if (sink->capacity - sink->size >= len)
+		return;
+
+	if (sink->fd != SINK_CAPTURE_FD) {
+		sink_write_buffer(sink);
+		if (sink->capacity >= len)
+			return;
+	}
+	size_t capacity = 2 * sink->capacity;
+	if (capacity < sink->size + len)
+		capacity = sink->size + len;
+	sink->buff = realloc(sink->buff, capacity);
+	DIE(sink->buff == NULL, "Failed to allocate memory\n");
+	sink->capacity = capacity;
+}
+
+/* functie care adauga un raspuns in buffer; loc se face pentru lungimea
+ * maxima a raspunsului formatat, calculata din lungimile campurilor
+*/
+static void sink_format_response(response_sink *sink, response *resp) {
+	size_t response_len = resp->server_response ?
+						  strlen(resp->server_response) : strlen("(null)");
+	size_t log_len = strlen(resp->server_log);
+	size_t max_len = sizeof(binary_response_header) + strlen(GENERIC_MSG) +
+					 2 * 11 + response_len + log_len + 1;
+	sink_reserve(sink, max_len);
+	size_t avail = sink->capacity - sink->size;
+
+	char *out = sink->buff + sink->size;
+	if (sink->binary) {
+		binary_response_header header;
+		header.server_id = resp->server_id;
+		header.response_len = resp->server_response ?
+							  (int32_t)response_len : -1;
+		header.log_len = log_len;
+
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		if (resp->server_response) {
+			memcpy(out, resp->server_response, header.response_len);
+			out += header.response_len;
+		}
+		memcpy(out, resp->server_log, header.log_len);
+		out += header.log_len;
+		sink->size = out - sink->buff;
+	} else {
+		// un raspuns NULL se afiseaza "(null)", ca la printf
+		int len = snprintf(out, avail, GENERIC_MSG, resp->server_id,
+						   resp->server_response ? resp->server_response :
+						   "(null)", resp->server_id, resp->server_log);
+		DIE(len < 0 || (size_t)len >= avail, "response too long");
+		sink->size += len;
+	}
+}
+
+/* thread-ul de output: formateaza raspunsurile in ordinea in care au fost
+ * scrise si le intoarce pentru refolosire; un raspuns NULL il opreste
+*/
+static void *sink_output_thread(void *arg) {
+	response_sink *sink = arg;
+	response *resp;
+
+	while (1) {
+		spsc_pop(sink->pending, &resp);
+		if (resp == NULL)
+			break;
+		while (resp) {
+			response *next = resp->next;
+			sink_format_response(sink, resp);
+			// daca nici coada de intoarcere nu mai are loc, raspunsul se
+			// elibereaza
+			if (!spsc_try_push(sink->recycled, &resp)) {
+				free(resp->log_buff);
+				free(resp->response_buff);
+				free(resp);
+			}
+			resp = next;
+		}
+	}
+	sink_write_buffer(sink);
+	return NULL;
+}
+
+void sink_write_bytes(response_sink *sink, const char *data, size_t len) {
+	if (len == 0)
+		return;
+	sink_reserve(sink, len);
+	memcpy(sink->buff + sink->size, data, len);
+	sink->size += len;
+}
+
+void sink_swap_buffer(response_sink *sink, char **buff, size_t *size,
+					  size_t *capacity) {
+	char *aux_buff = sink->buff;
+	size_t aux_size = sink->size;
+	size_t aux_capacity = sink->capacity;
+
+	sink->buff = *buff;
+	sink->size = *size;
+	sink->capacity = *capacity;
+	*buff = aux_buff;
+	*size = aux_size;
+	*capacity = aux_capacity;
+}
+
+void sink_start_thread(response_sink *sink) {
+	sink->pending = spsc_create(SINK_QUEUE_SIZE, sizeof(response *));
+	sink->recycled = spsc_create(2 * SINK_QUEUE_SIZE, sizeof(response *));
+	sink->threaded = true;
+	DIE(pthread_create(&sink->thread, NULL, sink_output_thread, sink) != 0,
+		"pthread_create failed");
+}
+
+void sink_write_response(response_sink *sink, response *resp) {
+	if (sink->threaded) {
+		spsc_push(sink->pending, &resp);
+		return;
+	}
+	while (resp) {
+		response *next = resp->next;
+		sink_format_response(sink, resp);
+		sink_recycle_response(sink, resp);
+		resp = next;
+	}
+}
+
+void sink_flush(response_sink *sink) {
+	if (sink->threaded) {
+		// raspunsul NULL opreste thread-ul dupa cele aflate deja in coada
+		response *stop = NULL;
+		spsc_push(sink->pending, &stop);
+		pthread_join(sink->thread, NULL);
+		sink->threaded = false;
+
+		// raspunsurile intoarse trec in lista de raspunsuri refolosibile
+		response *resp;
+		while (spsc_try_pop(sink->recycled, &resp))
+			sink_recycle_response(sink, resp);
+		spsc_free(sink->pending);
+		spsc_free(sink->recycled);
+		sink->pending = NULL;
+		sink->recycled = NULL;
+	}
+	sink_write_buffer(sink);
+}
+
+void free_response_sink(response_sink **sink) {
+	sink_flush(*sink);
+
+	response *resp = (*sink)->free_responses;
+	while (resp) {
+		response *next = resp->next;
+		free(resp->log_buff);
+		free(resp->response_buff);
+		free(resp);
+		resp = next;
+	}
+
+	free((*sink)->buff);
+	free(*sink);
+	*sink = NULL;
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef RESPONSE_SINK_H
+#define RESPONSE_SINK_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "constants.h"
+#include "spsc_queue.h"
+
+#define MAX_LOG_LENGTH 1000
+#define MAX_RESPONSE_LENGTH 4096
+#define SINK_BUFFER_SIZE (1 << 20)
+// un sink cu acest descriptor doar captureaza outputul in buffer
+#define SINK_CAPTURE_FD -1
+// numarul de raspunsuri care pot astepta thread-ul de output
+#define SINK_QUEUE_SIZE 4096
+
+/* raspunsul unui server; log-ul si raspunsul sunt formatate in bufferele
+ * proprii ale raspunsului, care raman alocate cand raspunsul este refolosit
+*/
+typedef struct response {
+	char *server_log;
+	// NULL daca documentul cerut nu exista
+	char *server_response;
+	int server_id;
+	char *log_buff;
+	char *response_buff;
+	size_t log_cap;
+	size_t response_cap;
+	// urmatorul raspuns din lista: raspunsurile care se scriu impreuna sau
+	// cele refolosibile
+	struct response *next;
+} response;
+
+/* header-ul unei inregistrari din modul binar, urmat de raspuns (daca
+ * response_len nu este -1) si de log, fara terminatorul '\0'
+*/
+typedef struct binary_response_header {
+	int32_t server_id;
+	int32_t response_len;
+	int32_t log_len;
+} binary_response_header;
+
+typedef struct response_sink {
+	int fd;
+	bool binary;
+	// bufferul in care sunt formatate raspunsurile, cat este ocupat si
+	// capacitatea lui
+	char *buff;
+	size_t size;
+	size_t capacity;
+	// raspunsurile deja scrise, care pot fi refolosite
+	response *free_responses;
+	// numarul de apeluri write facute
+	unsigned long nr_writes;
+	// in modul cu thread, raspunsurile sunt formatate si scrise de
+	// thread-ul de output, care le primeste prin pending si le intoarce
+	// prin recycled
+	bool threaded;
+	pthread_t thread;
+	spsc_queue_t *pending;
+	spsc_queue_t *recycled;
+} response_sink;
+
+/**
+ * init_response_sink() - Creates a sink which writes responses to fd.
+ *
+ * @param fd: File descriptor the output is written to. With
+ *      SINK_CAPTURE_FD, the output is only gathered in the sink's buffer,
+ *      which grows as needed, and is taken with sink_swap_buffer().
+ * @param binary: If true, responses are written as binary records
+ *      (binary_response_header followed by the fields) instead of text.
+ */
+response_sink *init_response_sink(int fd, bool binary);
+
+/**
+ * sink_start_thread() - Moves formatting and writing to an output thread.
+ *      Responses written afterwards are handed to it through a bounded
+ *      lock-free queue and come back for reuse through another one. The
+ *      sink must then be used from a single other thread.
+ */
+void sink_start_thread(response_sink *sink);
+
+/**
+ * sink_new_response() - Returns an empty response for server_id, reusing
+ *      a response already written to the sink when there is one. Its
+ *      fields are NULL until set with response_set_log() and
+ *      response_set_response().
+ */
+response *sink_new_response(response_sink *sink, int server_id);
+
+/**
+ * response_set_log() - Formats the log of a response into its own buffer,
+ *      truncated to MAX_LOG_LENGTH - 1 characters.
+ */
+void response_set_log(response *resp, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+/**
+ * response_set_response() - Formats the response text into its own buffer,
+ *      truncated to MAX_RESPONSE_LENGTH - 1 characters.
+ */
+void response_set_response(response *resp, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+/**
+ * sink_write_response() - Appends a response, and the ones linked after
+ *      it through next, to the output buffer, in GENERIC_MSG format or as
+ *      binary records, and takes the responses back for reuse. The buffer
+ *      is written out with a single write() when it cannot hold the next
+ *      response.
+ */
+void sink_write_response(response_sink *sink, response *resp);
+
+/**
+ * sink_write_bytes() - Appends already formatted output to the sink.
+ */
+void sink_write_bytes(response_sink *sink, const char *data, size_t len);
+
+/**
+ * sink_swap_buffer() - Exchanges the sink's buffer with the one described
+ *      by buff, size and capacity. Used to take the output gathered by a
+ *      capturing sink without copying it.
+ */
+void sink_swap_buffer(response_sink *sink, char **buff, size_t *size,
+					  size_t *capacity);
+
+/**
+ * sink_recycle_response() - Takes back a response without writing it.
+ */
+void sink_recycle_response(response_sink *sink, response *resp);
+
+/**
+ * sink_flush() - Writes out everything buffered so far. If the sink has
+ *      an output thread, waits for it to write all the pending responses
+ *      and stops it.
+ */
+void sink_flush(response_sink *sink);
+
+/**
+ * free_response_sink() - Flushes the sink and frees it, together with the
+ *      responses kept for reuse.
+ */
+void free_response_sink(response_sink **sink);
+
+#endif /* RESPONSE_SINK_H */
@@ -10,117 +10,202 @@
 #include "lru_cache.h"
 #include "utils.h"
 
+/* functie care cauta un document in database-ul serverului, folosind
+ * indexul dupa nume, si returneaza nodul din lista care il contine
+*/
+dll_node_t *server_find_document(server *s, char *doc_name) {
+	return ht_get(s->db_index, doc_name);
+}
+
+/* functie care adauga serverului arcul de ring incheiat de una dintre
+ * etichetele lui, pastrand arcele sortate dupa hashul etichetei
+*/
+void server_add_arc(server *s, unsigned int label_hash) {
+	s->arcs = realloc(s->arcs, (s->nr_arcs + 1) * sizeof(db_arc));
+	DIE(s->arcs == NULL, "Failed to allocate memory\n");
+
+	int i = s->nr_arcs;
+	while (i > 0 && s->arcs[i - 1].hash > label_hash) {
+		s->arcs[i] = s->arcs[i - 1];
+		i--;
+	}
+	s->arcs[i].hash = label_hash;
+	s->arcs[i].docs = dll_create(sizeof(doc_t));
+	s->nr_arcs++;
+}
+
+/* functie care cauta binar arcul pe care se afla un document: primul arc
+ * incheiat de o eticheta cu hashul strict mai mare decat al documentului;
+ * daca nu exista, documentul se afla pe arcul care trece prin 0, adica
+ * primul arc
+ * printre etichetele serverului, aceasta este chiar eticheta care detine
+ * documentul pe hash ring
+*/
+db_arc *server_find_arc(server *s, unsigned int doc_hash) {
+	int lo = 0, len = s->nr_arcs;
+	while (len > 0) {
+		int half = len / 2;
+		if (s->arcs[lo + half].hash <= doc_hash) {
+			lo += half + 1;
+			len -= half + 1;
+		} else {
+			len = half;
+		}
+	}
+	if (lo == s->nr_arcs)
+		lo = 0;
+	return &s->arcs[lo];
+}
+
+/* functie care adauga un document la finalul arcului sau din database si
+ * il inregistreaza in index; indexul foloseste chiar numele documentului
+ * din database drept cheie
+*/
+dll_node_t *server_store_document(server *s, doc_t *doc) {
+	dll_t *docs = server_find_arc(s, doc->hash)->docs;
+	dll_add_nth_node(docs, docs->size, doc);
+	dll_node_t *node = docs->tail;
+	ht_put(s->db_index, ((doc_t *)node->data)->doc_name, 0, node, 0);
+	s->nr_docs++;
+	return node;
+}
+
+/* functie care scoate un nod din database si din index, fara a-l elibera
+*/
+void server_unlink_document(server *s, dll_node_t *node) {
+	doc_t *doc = node->data;
+	ht_remove_entry(s->db_index, doc->doc_name);
+	dll_remove_node(server_find_arc(s, doc->hash)->docs, node);
+	s->nr_docs--;
+}
+
+/* functie care adauga in database un nod scos din database-ul altui
+ * server; documentul nu este copiat
+*/
+void server_link_document(server *s, dll_node_t *node) {
+	doc_t *doc = node->data;
+	dll_link_node(server_find_arc(s, doc->hash)->docs, node);
+	ht_put(s->db_index, doc->doc_name, 0, node, 0);
+	s->nr_docs++;
+}
+
+/* functie care adauga in database o copie a unui document de pe alt server
+*/
+void server_copy_document(server *s, doc_t *doc) {
+	doc_t copy;
+	copy.doc_name = copy_string(doc->doc_name, DOC_NAME_LENGTH);
+	copy.doc_content = doc->doc_content ?
+		copy_string(doc->doc_content, DOC_CONTENT_LENGTH) : NULL;
+	copy.hash = doc->hash;
+	server_store_document(s, &copy);
+}
+
+/* functie care sterge un document din database si din cache-ul serverului
+*/
+void server_drop_document(server *s, dll_node_t *node) {
+	lru_cache_remove(s->cache, ((doc_t *)node->data)->doc_name);
+	server_unlink_document(s, node);
+	doc_t_free_function(node->data);
+	free(node->data);
+	free(node);
+}
+
+/* functie care muta toate documentele unui arc al serverului src pe
+ * serverul dst; lista arcului este lipita la finalul arcului destinatie,
+ * iar documentele sunt doar adaugate in indexul lui dst
+*/
+void server_move_arc(server *src, db_arc *arc, server *dst) {
+	if (arc->docs->head == NULL)
+		return;
+
+	// documentele arcului au acelasi proprietar, deci primul dintre ele
+	// da arcul destinatie
+	doc_t *first = arc->docs->head->data;
+	db_arc *dst_arc = server_find_arc(dst, first->hash);
+	for (dll_node_t *node = arc->docs->head; node; node = node->next)
+		ht_put(dst->db_index, ((doc_t *)node->data)->doc_name, 0, node, 0);
+
+	src->nr_docs -= arc->docs->size;
+	dst->nr_docs += arc->docs->size;
+	dll_splice(dst_arc->docs, arc->docs);
+}
+
+/* functie care returneaza bytes ocupati de continutul unui document
+*/
+static size_t doc_content_size(doc_t *doc) {
+	return doc->doc_content ? strlen(doc->doc_content) + 1 : 0;
+}
+
+/* functie care adauga in cache o referinta la un document din database si
+ * completeaza log-ul corespunzator unui MISS, care precizeaza si cheia
+ * eliminata, daca cache-ul a fost plin
+*/
+static void server_cache_document(server *s, doc_t *doc, response *resp) {
+	void *evicted_key = NULL;
+	// se adauga in cache; cheia si valoarea sunt cele din database, iar
+	// cache-ul numara si bytes continutului
+	lru_cache_put(s->cache, doc->doc_name, doc, doc_content_size(doc),
+				  &evicted_key);
+	if (evicted_key) {
+		// cache a fost plin si s-a eliminat o cheie
+		response_set_log(resp, LOG_EVICT, (char *)doc->doc_name,
+						 (char *)evicted_key);
+		free(evicted_key);
+	} else {
+		// cache nu a fost plin
+		response_set_log(resp, LOG_MISS, (char *)doc->doc_name);
+	}
+}
+
+/* functie care inlocuieste continutul unui document din database cu o copie
+ * de dimensiune exacta a noului continut
+ * cache-ul retine o referinta la document, deci vede noul continut
+*/
+static void server_set_content(doc_t *doc, char *doc_content) {
+	free(doc->doc_content);
+	doc->doc_content = copy_string(doc_content, DOC_CONTENT_LENGTH);
+}
+
 /* functie care se ocupa de requesturile de tipul EDIT si returneaza
  * response-ul corespunzator
 */
 static response *server_edit_document(server *s, char *doc_name,
 									  char *doc_content) {
-	// se aloca memorie pentru response
-	response *resp = malloc(sizeof(response));
-	DIE(resp == NULL, "Failed to allocate memory\n");
-
-	resp->server_log = malloc(MAX_LOG_LENGTH * sizeof(char));
-	DIE(resp->server_log == NULL, "Failed to allocate memory\n");
+	// se ia un response din sink-ul serverului
+	response *resp = sink_new_response(s->sink, s->id);
 
-	resp->server_response = malloc(MAX_RESPONSE_LENGTH * sizeof(char));
-	DIE(resp->server_response == NULL, "Failed to allocate memory\n");
-
-	resp->server_id = s->id;
 	// se cauta daca documentul este in cache
-	dll_node_t *ptr_to_content = lru_cache_get(s->cache, doc_name);
-	if (ptr_to_content) {
-		// daca documentul este in cache, se modifica continutul acestuia
-		// si se actualizeaza log-ul si respunsul
-		snprintf(resp->server_response, MAX_RESPONSE_LENGTH, MSG_B, doc_name);
-		snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_HIT, doc_name);
-
-		// se modifica continutul documentului din cache, din lista de recente
-		snprintf(((info *)ptr_to_content->data)->value, DOC_CONTENT_LENGTH,
-				 "%s", doc_content);
-
-		// se modifica continutul documentului din database
-		dll_node_t *aux = s->database->head;
-		for (unsigned int i = 0; i < s->database->size; i++) {
-			if (!strcmp((char *)((doc_t *)aux->data)->doc_name, doc_name)) {
-				snprintf((char *)((doc_t *)aux->data)->doc_content, DOC_CONTENT_LENGTH,
-						 "%s", doc_content);
-				break;
-			}
-			aux = aux->next;
-		}
+	doc_t *doc = lru_cache_get(s->cache, doc_name);
+	if (doc) {
+		// daca documentul este in cache, se actualizeaza log-ul si respunsul
+		response_set_response(resp, MSG_B, doc_name);
+		response_set_log(resp, LOG_HIT, doc_name);
+		// se modifica continutul, iar cache-ul numara noua lui dimensiune
+		server_set_content(doc, doc_content);
+		lru_cache_resize(s->cache, doc->doc_name, doc_content_size(doc));
 	} else {
 		// documentul nu e in cache, se cauta in database
-		unsigned int i = 0;
-		dll_node_t *aux = s->database->head;
-		for (i = 0; i < s->database->size; i++) {
-			if (!strcmp((char *)((doc_t *)aux->data)->doc_name, doc_name)) {
-				// s-a gasit documentul in database
-				break;
-			}
-			aux = aux->next;
-		}
-
-		if (i == s->database->size || aux == NULL) {
-			// documentul nu e in database, se adauga in cache si in database
-			void *evicted_key = NULL;
-			char *doc_copy = strdup(doc_name);
-			// se adauga in cache
-			lru_cache_put(s->cache, doc_name, doc_content, &evicted_key);
-			if (evicted_key) {
-				// cache a fost plin si s-a eliminat o cheie
-				// se actualizeaza log-ul
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_EVICT, doc_copy,
-						(char *)evicted_key);
-				free(evicted_key);
-			} else {
-				// cache nu a fost plin
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_MISS, doc_name);
-			}
-			free(doc_copy);
-
-			// se aloca memorie pentru o noua intrare in database
-			doc_t *new_node = malloc(sizeof(doc_t));
-			DIE(new_node == NULL, "Failed to allocate memory\n");
-
-			new_node->doc_content = malloc(DOC_CONTENT_LENGTH * sizeof(char));
-			DIE(new_node->doc_content == NULL, "Failed to allocate memory\n");
-			snprintf((char *)new_node->doc_content, DOC_CONTENT_LENGTH, "%s",
-					 doc_content);
-
-			new_node->doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-			DIE(new_node->doc_name == NULL, "Failed to allocate memory\n");
-			snprintf((char *)new_node->doc_name, DOC_NAME_LENGTH, "%s",
-					 doc_name);
-
-			// se adauga in database si se actualizeaza response-ul
-			dll_add_nth_node(s->database, s->database->size, new_node);
-			free(new_node);
-			snprintf(resp->server_response, MAX_RESPONSE_LENGTH, MSG_C,
-					 doc_name);
+		dll_node_t *aux = server_find_document(s, doc_name);
+
+		if (aux == NULL) {
+			// documentul nu e in database, se adauga in database, de
+			// dimensiunea exacta a numelui si a continutului, si in cache
+			doc_t new_node;
+			new_node.doc_name = copy_string(doc_name, DOC_NAME_LENGTH);
+			new_node.doc_content = NULL;
+			new_node.hash = hash_string(doc_name);
+			doc = server_store_document(s, &new_node)->data;
+
+			response_set_response(resp, MSG_C, doc_name);
 		} else {
-			// documentul este in database, se adauga in cache si se
-			// actualizeaza continutul acestuia
-			void *evicted_key = NULL;
-			// se adauga in cache
-			lru_cache_put(s->cache, doc_name, doc_content, &evicted_key);
-			if (evicted_key) {
-				// cache a fost plin si s-a eliminat o cheie
-				// se actualizeaza log-ul
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_EVICT, doc_name,
-						(char *)evicted_key);
-				free(evicted_key);
-			} else {
-				// cache nu a fost plin
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_MISS, doc_name);
-			}
-
-			// se modifica continutul documentului din database
-			snprintf((char *)((doc_t *)aux->data)->doc_content,
-			 		 DOC_CONTENT_LENGTH, "%s", doc_content);
-			// se actualizeaza response-ul
-			snprintf(resp->server_response, MAX_RESPONSE_LENGTH, MSG_B,
-					 doc_name);
+			// documentul este in database, se adauga in cache
+			doc = aux->data;
+			response_set_response(resp, MSG_B, doc_name);
 		}
+		// se modifica continutul documentului, o singura data, in
+		// database, inainte ca acesta sa fie numarat de cache
+		server_set_content(doc, doc_content);
+		server_cache_document(s, doc, resp);
 	}
 	return resp;
 }
@@ -129,86 +214,115 @@ static response *server_edit_document(server *s, char *doc_name,
  * response-ul corespunzator
 */
 static response *server_get_document(server *s, char *doc_name) {
-	// se aloca memorie pentru response
-	response *resp = malloc(sizeof(response));
-	DIE(resp == NULL, "Failed to allocate memory\n");
-
-	resp->server_log = malloc(MAX_LOG_LENGTH * sizeof(char));
-	DIE(resp->server_log == NULL, "Failed to allocate memory\n");
-
-	resp->server_id = s->id;
+	// se ia un response din sink-ul serverului
+	response *resp = sink_new_response(s->sink, s->id);
 
 	// se cauta daca documentul este in cache
-	dll_node_t *ptr_to_content = lru_cache_get(s->cache, doc_name);
-	if (ptr_to_content) {
+	doc_t *doc = lru_cache_get(s->cache, doc_name);
+	if (doc) {
 		// daca documentul este in cache, se actualizeaza log-ul si
 		// response-ul este continutul documentului
-		resp->server_response = malloc(MAX_RESPONSE_LENGTH * sizeof(char));
-		DIE(resp->server_response == NULL, "Failed to allocate memory\n");
-		snprintf(resp->server_response, MAX_RESPONSE_LENGTH, "%s",
-			   (char *)((info *)ptr_to_content->data)->value);
-		snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_HIT, doc_name);
+		response_set_log(resp, LOG_HIT, doc_name);
 	} else {
 		// documentul nu e in cache, se cauta in database
-		unsigned int i = 0;
-		dll_node_t *aux = s->database->head;
-		for (i = 0; i < s->database->size; i++) {
-			if (!strcmp((char *)((doc_t *)aux->data)->doc_name, doc_name)) {
-				// s-a gasit documentul in database
-				break;
-			}
-			aux = aux->next;
-		}
+		dll_node_t *aux = server_find_document(s, doc_name);
 
-		if (i == s->database->size || aux == NULL) {
+		if (aux == NULL) {
 			// documentul nu e in database, se actualizeaza log-ul si
 			// response-ul este NULL
-			resp->server_response = NULL;
-			snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_FAULT, doc_name);
-		} else {
-			// documentul este in database, se adauga in cache si se returneaza
-			// continutul acestuia
-			resp->server_response = malloc(MAX_RESPONSE_LENGTH * sizeof(char));
-			DIE(resp->server_response == NULL, "Failed to allocate memory\n");
-
-			snprintf(resp->server_response, DOC_CONTENT_LENGTH, "%s",
-					 (char *)((doc_t *)aux->data)->doc_content);
-
-			// se adauga in cache
-			void *evicted_key = NULL;
-			lru_cache_put(s->cache, doc_name, resp->server_response,
-						  &evicted_key);
-			if (evicted_key) {
-				// cache a fost plin si s-a eliminat o cheie
-				// se actualizeaza log-ul
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_EVICT, doc_name,
-						(char *)evicted_key);
-				free(evicted_key);
-			} else {
-				// cache nu a fost plin
-				snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_MISS, doc_name);
-			}
+			response_set_log(resp, LOG_FAULT, doc_name);
+			return resp;
 		}
+		// documentul este in database, se adauga in cache
+		doc = aux->data;
+		server_cache_document(s, doc, resp);
 	}
+	// se returneaza continutul documentului
+	response_set_response(resp, "%s", (char *)doc->doc_content);
 	return resp;
 }
 
+/* functie care executa EDIT-urile din coada serverului si returneaza
+ * raspunsurile lor, inlantuite in ordine prin next
+*/
+response *server_run_queue(server *s) {
+	response *first = NULL;
+	response **last = &first;
+
+	while (q_is_empty(s->task_queue) == 0) {
+		// se executa toate request-urile de tipul EDIT din coada
+		request *to_process = q_front(s->task_queue);
+		// un EDIT anulat nu mai produce niciun raspuns
+		if (to_process->doc_name == NULL) {
+			s->cancelled_edits--;
+			q_dequeue(s->task_queue);
+			continue;
+		}
+		if (s->coalesce_edits)
+			ht_remove_entry(s->pending_edits, to_process->doc_name);
+
+		response *resp_edit = server_edit_document(s, to_process->doc_name,
+												   to_process->doc_content);
+		// se adauga raspunsul in lista si se elibereaza memoria
+		// request-ului
+		*last = resp_edit;
+		last = &resp_edit->next;
+
+		free(to_process->doc_name);
+		if (to_process->doc_content)
+			free(to_process->doc_content);
+
+		// se trece la urmatorul request
+		q_dequeue(s->task_queue);
+	}
+	return first;
+}
+
+/* functie care aplica imediat un EDIT, fara a-l pune in coada si fara
+ * raspuns; folosita pentru copiile unui document replicat
+*/
+void server_apply_edit(server *s, char *doc_name, char *doc_content) {
+	// numele este trunchiat ca la punerea in coada, ca documentul sa fie
+	// gasit si plasat la fel pe toate copiile
+	char *name = copy_string(doc_name, DOC_NAME_LENGTH);
+	sink_recycle_response(s->sink, server_edit_document(s, name,
+													   doc_content));
+	free(name);
+}
+
 /* functie care initializeaza un server cu un cache de dimensiune cache_size
  * si toate campurile acestuia
 */
-server *init_server(unsigned int cache_size) {
-	lru_cache *cache = init_lru_cache(cache_size);
-	queue_t *task_queue = q_create(TASK_QUEUE_SIZE, sizeof(request));
-	init_request_queue(task_queue);
-
-	dll_t *database = dll_create(sizeof(doc_t));
+server *init_server(unsigned int cache_size, const cache_config *config) {
+	lru_cache *cache = init_lru_cache(cache_size, config);
+	// coada isi mareste capacitatea la nevoie
+	queue_t *task_queue = q_create(TASK_QUEUE_INIT_SIZE, sizeof(request));
+
+	// indexul database-ului asociaza numelui unui document nodul din lista
+	hashtable_t *db_index = ht_create_ref(DB_INDEX_INIT_SIZE, hash_string,
+										  compare_function);
+	// indexul EDIT-urilor din coada, folosit doar la coalescing
+	hashtable_t *pending_edits = ht_create_ref(PENDING_EDITS_INIT_SIZE,
+											   hash_string, compare_function);
 
 	server *s = malloc(sizeof(server));
 	DIE(s == NULL, "Failed to allocate memory\n");
 
 	s->cache = cache;
 	s->task_queue = task_queue;
-	s->database = database;
+	// arcele sunt adaugate de load balancer, dupa etichetele serverului
+	s->arcs = NULL;
+	s->nr_arcs = 0;
+	s->nr_docs = 0;
+	s->db_index = db_index;
+	s->coalesce_edits = false;
+	s->pending_edits = pending_edits;
+	s->cancelled_edits = 0;
+	s->coalesced_edits = 0;
+	s->sink = NULL;
+	// tabela replicilor este creata la prima replica
+	s->replicas = NULL;
+	s->nr_requests = 0;
 	return s;
 }
 /* functie care se ocupa de requesturile primite de la client si returneaza
@@ -219,73 +333,136 @@ response *server_handle_request(server *s, request *req) {
 	response *resp;
 	// se verifica tipul request-ului si se apeleaza functia corespunzatoare
 	if (!strcmp(type, "EDIT")) {
-		// se face o copie a requestului pentru a fi adaugat in coada
-		request *req_copy = malloc(sizeof(request));
-		DIE(req_copy == NULL, "Failed to allocate memory\n");
-
-		req_copy->type = req->type;
-		req_copy->doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-		DIE(req_copy->doc_name == NULL, "Failed to allocate memory\n");
-
-		snprintf(req_copy->doc_name, DOC_NAME_LENGTH, "%s", req->doc_name);
-		req_copy->doc_content = NULL;
-		if (req->doc_content != NULL) {
-			req_copy->doc_content = malloc(DOC_CONTENT_LENGTH * sizeof(char));
-			DIE(req_copy->doc_content == NULL, "Failed to allocate memory\n");
-
-			snprintf(req_copy->doc_content, DOC_CONTENT_LENGTH, "%s", req->doc_content);
+		// se face o copie a requestului pentru a fi adaugat in coada, cu
+		// campuri de dimensiunea exacta a numelui si a continutului
+		request req_copy;
+		req_copy.type = req->type;
+		req_copy.doc_name = copy_string(req->doc_name, DOC_NAME_LENGTH);
+		req_copy.doc_content = NULL;
+		if (req->doc_content != NULL)
+			req_copy.doc_content = copy_string(req->doc_content,
+											   DOC_CONTENT_LENGTH);
+
+		// un EDIT mai vechi pentru acelasi document, aflat inca in coada,
+		// este anulat, iar cel nou se adauga la final, ca ordinea in care
+		// documentele ajung in cache sa ramana cea de la executia completa
+		if (s->coalesce_edits) {
+			request *pending = ht_get(s->pending_edits, req_copy.doc_name);
+			if (pending) {
+				ht_remove_entry(s->pending_edits, pending->doc_name);
+				free(pending->doc_name);
+				free(pending->doc_content);
+				pending->doc_name = NULL;
+				pending->doc_content = NULL;
+				s->cancelled_edits++;
+				s->coalesced_edits++;
+			}
 		}
 
-		// se adauga request-ul in coada
-		q_enqueue(s->task_queue, req_copy);
-
-		// se aloca memorie pentru response
-		resp = malloc(sizeof(response));
-		DIE(resp == NULL, "Failed to allocate memory\n");
-
-		resp->server_log = malloc(MAX_LOG_LENGTH * sizeof(char));
-		DIE(resp->server_log == NULL, "Failed to allocate memory\n");
-
-		resp->server_response = malloc(MAX_RESPONSE_LENGTH * sizeof(char));
-		DIE(resp->server_response == NULL, "Failed to allocate memory\n");
-
-		resp->server_id = s->id;
+		// se adauga request-ul in coada; daca aceasta era plina, bufferul
+		// ei a fost realocat, iar indexul trebuie refacut
+		bool grows = s->task_queue->size == s->task_queue->max_size;
+		q_enqueue(s->task_queue, &req_copy);
+		if (s->coalesce_edits && grows) {
+			for (unsigned int i = 0; i < s->task_queue->size; i++) {
+				request *queued = q_at(s->task_queue, i);
+				if (queued->doc_name)
+					ht_put(s->pending_edits, queued->doc_name, 0, queued, 0);
+			}
+		} else if (s->coalesce_edits) {
+			request *queued = q_back(s->task_queue);
+			ht_put(s->pending_edits, queued->doc_name, 0, queued, 0);
+		}
 
 		// se actualizeaza log-ul si response-ul
-		snprintf(resp->server_log, MAX_LOG_LENGTH, LOG_LAZY_EXEC,
-				 s->task_queue->size);
-		snprintf(resp->server_response, MAX_RESPONSE_LENGTH, MSG_A,
-				 type, req_copy->doc_name);
-
-		free(req_copy);
+		// dimensiunea cozii nu include EDIT-urile anulate
+		resp = sink_new_response(s->sink, s->id);
+		response_set_log(resp, LOG_LAZY_EXEC,
+						 s->task_queue->size - s->cancelled_edits);
+		response_set_response(resp, MSG_A, type, req_copy.doc_name);
 	} else if (!strcmp(type, "GET")) {
 		// se face o copie a numelui documentului pentru a fi folosit in
 		// functia server_get_document
-		char *doc_name = malloc(DOC_NAME_LENGTH * sizeof(char));
-		DIE(doc_name == NULL, "Failed to allocate memory\n");
+		char *doc_name = copy_string(req->doc_name, DOC_NAME_LENGTH);
+		// raspunsurile EDIT-urilor executate sunt inlantuite, in ordine,
+		// inaintea raspunsului GET-ului
+		response *first = server_run_queue(s);
+		response **last = &first;
+		while (*last)
+			last = &(*last)->next;
+		// se executa request-ul de tipul GET
+		*last = server_get_document(s, doc_name);
+		resp = first;
+		free(doc_name);
+	}
+	return resp;
+}
 
-		snprintf(doc_name, DOC_NAME_LENGTH, "%s", req->doc_name);
+void server_put_replica(server *s, char *doc_name, char *doc_content) {
+	// replicile detin copii ale numelor si ale continutului
+	if (s->replicas == NULL)
+		s->replicas = ht_create(REPLICAS_INIT_SIZE, hash_string,
+								compare_function, key_val_free_function);
+	// continutul este trunchiat la fel ca cel al documentului proprietarului
+	char *content = copy_string(doc_content, DOC_CONTENT_LENGTH);
+	ht_put(s->replicas, doc_name, strlen(doc_name) + 1, content,
+		   strlen(content) + 1);
+	free(content);
+}
 
-		while (q_is_empty(s->task_queue) == 0) {
-			// se executa toate request-urile de tipul EDIT din coada
-			request *to_process = q_front(s->task_queue);
-			response *resp_edit = server_edit_document(s, to_process->doc_name,
-													   to_process->doc_content);
-			// se printeaza raspunsul si se elibereaza memoria request-ului
-			PRINT_RESPONSE(resp_edit);
+void server_drop_replica(server *s, char *doc_name) {
+	if (s->replicas)
+		ht_remove_entry(s->replicas, doc_name);
+}
 
-			free(to_process->doc_name);
-			if (to_process->doc_content)
-				free(to_process->doc_content);
+/* functie care raspunde la un GET din replica unui document; replica este
+ * actualizata de load balancer, deci coada serverului nu este executata
+*/
+response *server_read_replica(server *s, char *doc_name) {
+	char *content = s->replicas ? ht_get(s->replicas, doc_name) : NULL;
+	if (content == NULL)
+		return NULL;
+
+	response *resp = sink_new_response(s->sink, s->id);
+	response_set_log(resp, LOG_REPLICA, doc_name);
+	response_set_response(resp, "%s", content);
+	return resp;
+}
 
-			// se trece la urmatorul request
-			q_dequeue(s->task_queue);
+/* functie care calculeaza memoria ocupata de un server, pe componente
+*/
+void server_memory_usage(server *s, server_memory *mem) {
+	// database-ul: arcele, nodurile listelor, documentele si indexul,
+	// impreuna cu tabela replicilor
+	mem->database = s->nr_arcs * (sizeof(db_arc) + sizeof(dll_t)) +
+					ht_memory_usage(s->db_index);
+	if (s->replicas)
+		mem->database += ht_memory_usage(s->replicas);
+	for (int i = 0; i < s->nr_arcs; i++) {
+		dll_node_t *node = s->arcs[i].docs->head;
+		for (; node; node = node->next) {
+			doc_t *doc = node->data;
+			mem->database += sizeof(dll_node_t) + sizeof(doc_t) +
+							 strlen(doc->doc_name) + 1;
+			if (doc->doc_content)
+				mem->database += strlen(doc->doc_content) + 1;
 		}
-		// se executa request-ul de tipul GET
-		resp = server_get_document(s, doc_name);
-		free(doc_name);
 	}
-	return resp;
+
+	mem->cache = lru_cache_memory_usage(s->cache);
+
+	// coada: sloturile si campurile requesturilor in asteptare
+	queue_t *q = s->task_queue;
+	mem->queue = sizeof(queue_t) + (size_t)q->max_size * q->data_size +
+				 ht_memory_usage(s->pending_edits);
+	for (unsigned int i = 0; i < q->size; i++) {
+		request *req = q_at(q, i);
+		if (req->doc_name == NULL)
+			continue;
+		mem->queue += strlen(req->doc_name) + 1;
+		if (req->doc_content)
+			mem->queue += strlen(req->doc_content) + 1;
+	}
 }
 
 /* funcie care elibereaza memoria alocata pentru un server
@@ -296,17 +473,24 @@ void free_server(server **s) {
 	free_lru_cache(&((*s)->cache));
 
 	q_free((*s)->task_queue);
-
-	// se elibereaza memoria unei liste dublu inlantuite
-	// si a documentelor din aceasta
-	dll_node_t *node = ((*s)->database)->head;
-	while (node != NULL) {
-		dll_node_t *aux = node;
-		node = node->next;
-		doc_t_free_function(aux->data);
-		free(aux->data);
-		free(aux);
+	ht_free((*s)->pending_edits);
+
+	// se elibereaza memoria listelor dublu inlantuite ale arcelor
+	// si a documentelor din acestea
+	for (int i = 0; i < (*s)->nr_arcs; i++) {
+		dll_node_t *node = (*s)->arcs[i].docs->head;
+		while (node != NULL) {
+			dll_node_t *aux = node;
+			node = node->next;
+			doc_t_free_function(aux->data);
+			free(aux->data);
+			free(aux);
+		}
+		free((*s)->arcs[i].docs);
 	}
-	free(((*s)->database));
+	free((*s)->arcs);
+	ht_free((*s)->db_index);
+	if ((*s)->replicas)
+		ht_free((*s)->replicas);
 	free(*s);
 }
@@ -7,16 +7,52 @@
 
 #include "constants.h"
 #include "lru_cache.h"
+#include "response_sink.h"
 #include "utils.h"
 
-#define TASK_QUEUE_SIZE 1000
-#define MAX_LOG_LENGTH 1000
-#define MAX_RESPONSE_LENGTH 4096
+#define TASK_QUEUE_INIT_SIZE 16
+#define DB_INDEX_INIT_SIZE 64
+#define PENDING_EDITS_INIT_SIZE 16
+#define REPLICAS_INIT_SIZE 16
+
+/* documentele unui server aflate pe arcul de ring care se incheie la una
+ * dintre etichetele serverului
+*/
+typedef struct db_arc {
+	// hashul etichetei care incheie arcul
+	unsigned int hash;
+	dll_t *docs;
+} db_arc;
 
 typedef struct server {
+	// cache-ul retine referinte la documentele din database
 	lru_cache *cache;
 	queue_t *task_queue;
-	dll_t *database;
+	// database-ul, impartit pe arcele de ring ale serverului, sortate
+	// crescator dupa hashul etichetei care le incheie
+	db_arc *arcs;
+	int nr_arcs;
+	// numarul total de documente din database
+	unsigned int nr_docs;
+	// index dupa numele documentului peste nodurile din database
+	hashtable_t *db_index;
+	// daca este activat, un EDIT nou inlocuieste EDIT-ul aflat deja in
+	// coada pentru acelasi document
+	bool coalesce_edits;
+	// index dupa numele documentului peste EDIT-urile din coada
+	hashtable_t *pending_edits;
+	// EDIT-urile anulate care inca ocupa un loc in coada
+	unsigned int cancelled_edits;
+	// numarul total de EDIT-uri inlocuite de unul mai nou
+	unsigned int coalesced_edits;
+	// sink-ul din care se iau raspunsurile si in care se scriu cele ale
+	// EDIT-urilor executate la golirea cozii
+	response_sink *sink;
+	// copiile read-only ale documentelor fierbinti ale altor servere,
+	// nume -> continut
+	hashtable_t *replicas;
+	// requesturile primite de la client, numarate de load balancer
+	unsigned long nr_requests;
 	int id;
 } server;
 
@@ -26,13 +62,135 @@ typedef struct request {
 	char *doc_content;
 } request;
 
-typedef struct response {
-	char *server_log;
-	char *server_response;
-	int server_id;
-} response;
+typedef struct server_memory {
+	// documentele din database, nodurile listei si indexul
+	size_t database;
+	// cache-ul, impreuna cu valorile lui
+	size_t cache;
+	// coada de taskuri, impreuna cu requesturile din ea
+	size_t queue;
+} server_memory;
+
+/**
+ * init_server() - Creates a server without documents, whose cache holds at
+ *      most cache_size documents, or cache_size bytes if config->in_bytes
+ *      is set, and evicts them by the policy in config.
+ */
+server *init_server(unsigned int cache_size, const cache_config *config);
+
+/**
+ * server_add_arc() - Gives the server the ring arc ending at one of its
+ *      labels. Must be called for every label before the server stores any
+ *      document.
+ *
+ * @param label_hash: Position of the label on the hash ring.
+ */
+void server_add_arc(server *s, unsigned int label_hash);
+
+/**
+ * server_find_arc() - Returns the arc a document hash falls on: the first
+ *      arc whose label hash is greater than doc_hash, wrapping around to
+ *      the first arc.
+ */
+db_arc *server_find_arc(server *s, unsigned int doc_hash);
+
+/**
+ * server_memory_usage() - Computes the memory held by a server, split
+ *      into database, cache and task queue. Allocator overhead is not
+ *      counted.
+ */
+void server_memory_usage(server *s, server_memory *mem);
+
+/**
+ * server_find_document() - Looks up a document in the server's database.
+ *
+ * @param s: Server which owns the database.
+ * @param doc_name: Name of the document.
+ *
+ * @return dll_node_t*: Database node holding the document, or NULL if the
+ *      document is not stored on this server.
+ */
+dll_node_t *server_find_document(server *s, char *doc_name);
+
+/**
+ * server_store_document() - Appends a document to its arc of the server's
+ *      database and indexes it by name. The fields of doc are taken over by
+ *      the database, the doc_t itself is copied.
+ *
+ * @return dll_node_t*: Database node holding the stored document.
+ */
+dll_node_t *server_store_document(server *s, doc_t *doc);
+
+/**
+ * server_unlink_document() - Removes a node from the server's database and
+ *      from its index. The node and its document are not freed.
+ */
+void server_unlink_document(server *s, dll_node_t *node);
 
-server *init_server(unsigned int cache_size);
+/**
+ * server_link_document() - Stores a node unlinked from another server's
+ *      database, without copying the document.
+ */
+void server_link_document(server *s, dll_node_t *node);
+
+/**
+ * server_copy_document() - Stores a copy of a document held by another
+ *      server, with its own name and content.
+ */
+void server_copy_document(server *s, doc_t *doc);
+
+/**
+ * server_drop_document() - Removes a document from the server's database
+ *      and cache and frees it.
+ */
+void server_drop_document(server *s, dll_node_t *node);
+
+/**
+ * server_move_arc() - Moves every document of one of src's arcs to dst in
+ *      O(1) list operations, plus indexing the documents on dst. All of
+ *      them must fall on the same arc of dst.
+ *
+ * @brief Meant for a server that is being removed: the name index and the
+ *      cache of src still refer to the moved documents, so src must be
+ *      freed right after.
+ */
+void server_move_arc(server *src, db_arc *arc, server *dst);
+
+/**
+ * server_put_replica() - Stores a read-only copy of another server's
+ *      document, replacing the previous copy, if any.
+ */
+void server_put_replica(server *s, char *doc_name, char *doc_content);
+
+/**
+ * server_drop_replica() - Removes the read-only copy of a document. Does
+ *      nothing if the server holds no copy of it.
+ */
+void server_drop_replica(server *s, char *doc_name);
+
+/**
+ * server_read_replica() - Answers a GET from the read-only copy of a
+ *      document, without running the task queue or touching the cache.
+ *
+ * @return response*: The response, or NULL if the server holds no copy of
+ *      the document.
+ */
+response *server_read_replica(server *s, char *doc_name);
+
+/**
+ * server_run_queue() - Runs the EDITs queued on the server.
+ *
+ * @return response*: Their responses, in order, linked through next, or
+ *      NULL if the queue was empty.
+ */
+response *server_run_queue(server *s);
+
+/**
+ * server_apply_edit() - Runs an EDIT at once, without queueing it and
+ *      without a response. Used for the copies of a replicated document,
+ *      whose first copy queues the EDIT and reports it.
+ */
+void server_apply_edit(server *s, char *doc_name, char *doc_content);
 
 /**
  * @brief Should deallocate completely the memory used by server,
@@ -49,12 +207,12 @@ void free_server(server **s);
  * @param req: Request to be processed.
  *
  * @return response*: Response of the requested operation, which will
- *      then be printed in main.
+ *      then be printed in main. For a GET, the responses of the queued
+ *      EDITs it executed come first, linked through next, and the GET's
+ *      own response is the last one in the list.
  *
  * @brief Based on the type of request, should call the appropriate
- *     solver, and should execute the tasks from queue if needed (in
- *     this case, after executing each task, PRINT_RESPONSE should
- *     be called).
+ *     solver, and should execute the tasks from queue if needed.
  */
 response *server_handle_request(server *s, request *req);
 
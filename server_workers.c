@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "server_workers.h"
+
+#include <sched.h>
+#include <stdlib.h>
+
+#include "utils.h"
+
+/* thread-ul unui worker: executa requesturile primite, formateaza
+ * raspunsurile in sink-ul workerului si muta outputul in future; un
+ * future NULL il opreste
+*/
+static void *worker_thread(void *arg) {
+	server_worker *worker = arg;
+	request_future *batch[WORKER_BATCH];
+
+	while (1) {
+		// se iau toate requesturile disponibile, pana la WORKER_BATCH;
+		// daca nu este niciunul, workerul asteapta si apoi doarme
+		size_t count = mpsc_wait_batch(worker->inbox, batch, WORKER_BATCH);
+		for (size_t i = 0; i < count; i++) {
+			request_future *future = batch[i];
+			if (future == NULL)
+				return NULL;
+
+			// raspunsurile EDIT-urilor executate la golirea cozii sunt
+			// scrise de server in acelasi sink, inaintea raspunsului
+			sink_swap_buffer(worker->sink, &future->output, &future->size,
+							 &future->capacity);
+			if (future->mode == FUTURE_COPY)
+				server_apply_edit(future->s, future->req.doc_name,
+								  future->req.doc_content);
+			else if (future->mode == FUTURE_DRAIN)
+				sink_write_response(worker->sink,
+									server_run_queue(future->s));
+			else
+				sink_write_response(worker->sink,
+									server_handle_request(future->s,
+														  &future->req));
+			sink_swap_buffer(worker->sink, &future->output, &future->size,
+							 &future->capacity);
+
+			atomic_store_explicit(&future->done, true, memory_order_release);
+		}
+	}
+}
+
+worker_pool *init_worker_pool(int nr_workers, response_sink *out) {
+	DIE(nr_workers < 1 || nr_workers > MAX_WORKERS,
+		"invalid number of workers");
+	worker_pool *pool = calloc(1, sizeof(worker_pool));
+	DIE(pool == NULL, "Failed to allocate memory\n");
+
+	pool->nr_workers = nr_workers;
+	pool->out = out;
+	for (int i = 0; i < nr_workers; i++) {
+		server_worker *worker = &pool->workers[i];
+		worker->inbox = mpsc_create(MAX_IN_FLIGHT, sizeof(request_future *));
+		worker->sink = init_response_sink(SINK_CAPTURE_FD, out->binary);
+		DIE(pthread_create(&worker->thread, NULL, worker_thread, worker) != 0,
+			"pthread_create failed");
+	}
+	return pool;
+}
+
+response_sink *worker_pool_sink(worker_pool *pool, int server_id) {
+	// id-ul poate fi negativ, deci restul este calculat fara semn
+	return pool->workers[(unsigned int)server_id % pool->nr_workers].sink;
+}
+
+/* functie care asteapta cel mai vechi request trimis si scrie outputul lui
+*/
+static void worker_pool_retire(worker_pool *pool) {
+	request_future *future = &pool->futures[pool->first_future];
+	for (unsigned int tries = 0;
+		 !atomic_load_explicit(&future->done, memory_order_acquire); tries++)
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+
+	if (future->mode != FUTURE_COPY)
+		sink_write_bytes(pool->out, future->output, future->size);
+	future->size = 0;
+	if (future->owned) {
+		free(future->req.doc_name);
+		free(future->req.doc_content);
+	}
+
+	pool->first_future = (pool->first_future + 1) % MAX_IN_FLIGHT;
+	pool->nr_futures--;
+}
+
+request_future *worker_pool_submit(worker_pool *pool, server *s,
+								   request *req, bool owned,
+								   future_mode mode) {
+	if (pool->nr_futures == MAX_IN_FLIGHT)
+		worker_pool_retire(pool);
+
+	unsigned int idx = (pool->first_future + pool->nr_futures) % MAX_IN_FLIGHT;
+	request_future *future = &pool->futures[idx];
+	atomic_store_explicit(&future->done, false, memory_order_relaxed);
+	future->s = s;
+	future->req = *req;
+	future->owned = owned;
+	future->mode = mode;
+	pool->nr_futures++;
+
+	// un server apartine mereu aceluiasi worker, deci requesturile lui se
+	// executa in ordinea in care au fost trimise
+	// acelasi worker ca in worker_pool_sink(), si pentru id-uri negative
+	unsigned int worker = (unsigned int)s->id % pool->nr_workers;
+	mpsc_push(pool->workers[worker].inbox, &future);
+	return future;
+}
+
+void worker_pool_wait_quorum(request_future **futures, int nr_futures,
+							 int quorum) {
+	for (unsigned int tries = 0;; tries++) {
+		int done = 0;
+		for (int i = 0; i < nr_futures; i++)
+			done += atomic_load_explicit(&futures[i]->done,
+										 memory_order_acquire);
+		if (done >= quorum)
+			return;
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+	}
+}
+
+void worker_pool_wait_all(worker_pool *pool) {
+	while (pool->nr_futures)
+		worker_pool_retire(pool);
+}
+
+void free_worker_pool(worker_pool **pool) {
+	worker_pool_wait_all(*pool);
+
+	for (int i = 0; i < (*pool)->nr_workers; i++) {
+		server_worker *worker = &(*pool)->workers[i];
+		request_future *stop = NULL;
+		mpsc_push(worker->inbox, &stop);
+		pthread_join(worker->thread, NULL);
+		mpsc_free(worker->inbox);
+		free_response_sink(&worker->sink);
+	}
+	for (int i = 0; i < MAX_IN_FLIGHT; i++)
+		free((*pool)->futures[i].output);
+
+	free(*pool);
+	*pool = NULL;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef SERVER_WORKERS_H
+#define SERVER_WORKERS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "mpsc_queue.h"
+#include "response_sink.h"
+#include "server.h"
+
+#define MAX_WORKERS 64
+// numarul maxim de requesturi trimise workerilor si neafisate inca
+#define MAX_IN_FLIGHT 4096
+// numarul maxim de requesturi luate o data din coada unui worker
+#define WORKER_BATCH 32
+
+// ce face workerul cu requestul unui future
+typedef enum future_mode {
+	// requestul este executat de server, iar outputul lui este scris
+	FUTURE_REQUEST,
+	// o copie a unui EDIT replicat, aplicata imediat si fara output
+	FUTURE_COPY,
+	// sunt executate doar EDIT-urile din coada serverului
+	FUTURE_DRAIN,
+} future_mode;
+
+/* rezultatul viitor al unui request trimis unui worker: outputul formatat
+ * al requestului (raspunsurile EDIT-urilor executate la golirea cozii si
+ * raspunsul requestului), gata cand done devine true
+*/
+typedef struct request_future {
+	_Atomic bool done;
+	server *s;
+	request req;
+	// daca numele si continutul requestului trebuie eliberate dupa executie
+	bool owned;
+	future_mode mode;
+	char *output;
+	size_t size;
+	size_t capacity;
+} request_future;
+
+/* un worker executa, in ordine, requesturile serverelor care ii apartin;
+ * raspunsurile sunt formatate in sink-ul lui, care doar captureaza outputul
+ * requesturile pot fi puse in coada lui de mai multe thread-uri
+*/
+typedef struct server_worker {
+	pthread_t thread;
+	mpsc_queue_t *inbox;
+	response_sink *sink;
+} server_worker;
+
+typedef struct worker_pool {
+	server_worker workers[MAX_WORKERS];
+	int nr_workers;
+	// requesturile in executie, in ordinea in care au fost trimise
+	request_future futures[MAX_IN_FLIGHT];
+	unsigned int first_future;
+	unsigned int nr_futures;
+	// sink-ul in care este scris outputul requesturilor terminate
+	response_sink *out;
+} worker_pool;
+
+/**
+ * init_worker_pool() - Starts nr_workers worker threads. Servers are
+ *      sharded over the workers by id.
+ *
+ * @param out: Sink the output of completed requests is written to, in the
+ *      order the requests were submitted.
+ */
+worker_pool *init_worker_pool(int nr_workers, response_sink *out);
+
+/**
+ * worker_pool_sink() - Returns the sink of the worker owning server_id.
+ *      A server's responses must be taken from and written to it.
+ */
+response_sink *worker_pool_sink(worker_pool *pool, int server_id);
+
+/**
+ * worker_pool_submit() - Queues req for s on the worker owning s and
+ *      returns its future. If MAX_IN_FLIGHT requests are pending, the
+ *      oldest one is waited for and retired first.
+ *
+ * @param owned: If true, the name and content of req are freed once the
+ *      request is retired.
+ * @param mode: How the worker runs req. The output of a FUTURE_COPY is
+ *      never written.
+ */
+request_future *worker_pool_submit(worker_pool *pool, server *s,
+								   request *req, bool owned,
+								   future_mode mode);
+
+/**
+ * worker_pool_wait_quorum() - Waits until at least quorum of the given
+ *      futures are done. The futures must not have been retired yet.
+ */
+void worker_pool_wait_quorum(request_future **futures, int nr_futures,
+							 int quorum);
+
+/**
+ * worker_pool_wait_all() - Waits for every submitted request and writes
+ *      their output, in order. Afterwards no worker touches any server
+ *      until the next submit.
+ */
+void worker_pool_wait_all(worker_pool *pool);
+
+/**
+ * free_worker_pool() - Retires the pending requests, stops the workers
+ *      and frees the pool.
+ */
+void free_worker_pool(worker_pool **pool);
+
+#endif /* SERVER_WORKERS_H */
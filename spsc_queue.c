@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#include "spsc_queue.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+/* functie care creeaza o coada cu capacitatea rotunjita la o putere a lui 2,
+ * astfel incat pozitia unui index in buffer se afla cu o masca
+*/
+spsc_queue_t *spsc_create(size_t capacity, size_t data_size) {
+	spsc_queue_t *q = malloc(sizeof(spsc_queue_t));
+	DIE(q == NULL, "Failed to allocate memory\n");
+
+	size_t size = 1;
+	while (size < capacity)
+		size <<= 1;
+
+	q->buff = malloc(size * data_size);
+	DIE(q->buff == NULL, "Failed to allocate memory\n");
+	q->mask = size - 1;
+	q->data_size = data_size;
+	atomic_init(&q->read_idx, 0);
+	atomic_init(&q->write_idx, 0);
+	q->cached_write_idx = 0;
+	q->cached_read_idx = 0;
+	return q;
+}
+
+/* indecsii cresc continuu, iar diferenta lor este numarul de elemente
+ * producatorul citeste indexul consumatorului doar cand copia lui locala
+ * arata coada plina
+*/
+bool spsc_try_push(spsc_queue_t *q, const void *data) {
+	size_t write_idx = atomic_load_explicit(&q->write_idx,
+											memory_order_relaxed);
+	if (write_idx - q->cached_read_idx > q->mask) {
+		q->cached_read_idx = atomic_load_explicit(&q->read_idx,
+												  memory_order_acquire);
+		if (write_idx - q->cached_read_idx > q->mask)
+			return false;
+	}
+
+	memcpy(q->buff + (write_idx & q->mask) * q->data_size, data,
+		   q->data_size);
+	// elementul copiat devine vizibil consumatorului odata cu indexul
+	atomic_store_explicit(&q->write_idx, write_idx + 1, memory_order_release);
+	return true;
+}
+
+bool spsc_try_pop(spsc_queue_t *q, void *data) {
+	size_t read_idx = atomic_load_explicit(&q->read_idx, memory_order_relaxed);
+	if (read_idx == q->cached_write_idx) {
+		q->cached_write_idx = atomic_load_explicit(&q->write_idx,
+												   memory_order_acquire);
+		if (read_idx == q->cached_write_idx)
+			return false;
+	}
+
+	memcpy(data, q->buff + (read_idx & q->mask) * q->data_size,
+		   q->data_size);
+	// slotul poate fi refolosit de producator abia dupa copiere
+	atomic_store_explicit(&q->read_idx, read_idx + 1, memory_order_release);
+	return true;
+}
+
+void spsc_push(spsc_queue_t *q, const void *data) {
+	for (unsigned int tries = 0; !spsc_try_push(q, data); tries++)
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+}
+
+void spsc_pop(spsc_queue_t *q, void *data) {
+	for (unsigned int tries = 0; !spsc_try_pop(q, data); tries++)
+		if (tries >= SPSC_SPIN_LIMIT)
+			sched_yield();
+}
+
+void spsc_free(spsc_queue_t *q) {
+	free(q->buff);
+	free(q);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024, Manolache Maria-Catalina 313CA
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CACHE_LINE_SIZE 64
+// numarul de incercari esuate dupa care un thread care asteapta cedeaza
+// procesorul
+#define SPSC_SPIN_LIMIT 64
+
+/* coada circulara marginita, fara lock-uri, pentru un singur producator si
+ * un singur consumator; elementele sunt copiate in buffer
+ * fiecare index este scris de un singur thread si sta pe linia lui de cache,
+ * impreuna cu copia locala a indexului celuilalt thread
+*/
+typedef struct spsc_queue_t {
+	// indexul urmatorului element citit, scris doar de consumator
+	_Atomic size_t read_idx;
+	size_t cached_write_idx;
+	char pad_read[CACHE_LINE_SIZE - sizeof(size_t) * 2];
+	// indexul urmatorului element scris, scris doar de producator
+	_Atomic size_t write_idx;
+	size_t cached_read_idx;
+	char pad_write[CACHE_LINE_SIZE - sizeof(size_t) * 2];
+	// capacitatea este o putere a lui 2
+	size_t mask;
+	size_t data_size;
+	char *buff;
+} spsc_queue_t;
+
+/**
+ * spsc_create() - Creates a bounded single-producer single-consumer queue.
+ *
+ * @param capacity: Minimum number of elements; rounded up to a power of 2.
+ * @param data_size: Size of an element, copied in and out of the queue.
+ */
+spsc_queue_t *spsc_create(size_t capacity, size_t data_size);
+
+/**
+ * spsc_try_push() - Copies data at the back of the queue. Must only be
+ *      called from the producer thread.
+ *
+ * @return bool: false if the queue is full.
+ */
+bool spsc_try_push(spsc_queue_t *q, const void *data);
+
+/**
+ * spsc_try_pop() - Copies the front element to data and removes it. Must
+ *      only be called from the consumer thread.
+ *
+ * @return bool: false if the queue is empty.
+ */
+bool spsc_try_pop(spsc_queue_t *q, void *data);
+
+/**
+ * spsc_push() - Like spsc_try_push(), but waits while the queue is full,
+ *      spinning first and then yielding the processor.
+ */
+void spsc_push(spsc_queue_t *q, const void *data);
+
+/**
+ * spsc_pop() - Like spsc_try_pop(), but waits while the queue is empty.
+ */
+void spsc_pop(spsc_queue_t *q, void *data);
+
+void spsc_free(spsc_queue_t *q);
+
+#endif /* SPSC_QUEUE_H */
@@ -5,6 +5,9 @@
 #ifndef STRUCTS_H
 #define STRUCTS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 typedef struct dll_node_t {
 	void *data;
 	struct dll_node_t *next;
@@ -19,27 +22,57 @@ typedef struct dll_t {
 } dll_t;
 
 typedef struct queue_t {
-	// dimensiunea maxima a cozii
+	// capacitatea curenta a cozii; se dubleaza cand coada este plina
 	unsigned int max_size;
 	// dimensiunea cozii
 	unsigned int size;
+	// dimensiunea maxima atinsa de coada
+	unsigned int high_water;
 	// dimensiunea in bytes a tipului de date stocat in coada
 	unsigned int data_size;
 	// indexul de la care se vor efectua operatiile de front si dequeue
 	unsigned int read_idx;
 	// indexul de la care se vor efectua operatiile de enqueue
 	unsigned int write_idx;
-	// bufferul ce stocheaza elementele cozii
-	void **buff;
+	// bufferul ce stocheaza elementele cozii, unul dupa altul
+	void *buff;
 } queue_t;
 
+typedef struct info {
+	void *key;
+	void *value;
+} info;
+
+// nr. de octeti de control comparati simultan la o sondare
+#define HT_GROUP_WIDTH 16
+// octetul de control al unui slot gol; un slot ocupat are ca octet de
+// control 7 biti din hashul cheii
+#define HT_EMPTY 0x80
+#define HT_TAG_MASK 0x7f
+// factorul maxim de incarcare al hashtable-ului (7/8)
+#define HT_MAX_LOAD_NUM 7
+#define HT_MAX_LOAD_DEN 8
+
+typedef struct ht_slot {
+	// hashul complet al cheii, pastrat pentru redimensionare si stergere
+	unsigned int hash;
+	info pair;
+} ht_slot;
+
 typedef struct hashtable_t {
-	// vector de liste dublu inlantuite
-	dll_t **buckets;
-	// nr. total de noduri existente curent in toate bucket-urile
+	// octetii de control ai sloturilor, urmati de o copie a primilor
+	// HT_GROUP_WIDTH octeti, pentru sondarea pe grupuri la final de vector
+	unsigned char *ctrl;
+	// vectorul de sloturi, cu adresare deschisa si sondare liniara
+	ht_slot *slots;
+	// nr. total de intrari existente curent in hashtable
 	unsigned int size;
-	// nr. de bucket-uri
+	// nr. de sloturi (putere a lui 2)
 	unsigned int hmax;
+	// 32 - log2(hmax), pentru obtinerea slotului de start din hash
+	unsigned int shift;
+	// true daca hashtable-ul detine copii ale cheilor si valorilor
+	bool owns_entries;
 	// pointer la o functie pentru a calcula valoarea hash asociata cheilor
 	unsigned int (*hash_function)(void *);
 	// pointer la o functie pentru a compara doua chei
@@ -49,14 +82,18 @@ typedef struct hashtable_t {
 	void (*key_val_free_function)(void *);
 } hashtable_t;
 
-typedef struct info {
-	void *key;
-	void *value;
-} info;
-
 typedef struct doc_t {
 	void *doc_name;
 	void *doc_content;
+	// hashul numelui, adica pozitia documentului pe hash ring
+	unsigned int hash;
 } doc_t;
 
+typedef struct ring_point {
+	// pozitia etichetei pe hash ring, calculata o singura data
+	unsigned int hash;
+	// slotul serverului caruia ii apartine eticheta
+	int slot;
+} ring_point;
+
 #endif /* STRUCTS_H */
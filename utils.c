@@ -24,6 +24,16 @@ unsigned int hash_string(void *key) {
 	return hash;
 }
 
+char *copy_string(const char *src, size_t max_len) {
+	size_t len = strnlen(src, max_len - 1);
+	char *copy = malloc(len + 1);
+	DIE(copy == NULL, "Failed to allocate memory\n");
+
+	memcpy(copy, src, len);
+	copy[len] = '\0';
+	return copy;
+}
+
 char *get_request_type_str(request_type req_type) {
 	switch (req_type) {
 		case ADD_SERVER:
@@ -45,6 +45,12 @@ unsigned int hash_uint(void *key);
  */
 unsigned int hash_string(void *key);
 
+/**
+ * @brief Allocates an exact-size copy of src, truncated like snprintf to
+ *      at most max_len - 1 characters
+ */
+char *copy_string(const char *src, size_t max_len);
+
 char *get_request_type_str(request_type req_type);
 request_type get_request_type(char *request_type_str);
 